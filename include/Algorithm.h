@@ -0,0 +1,44 @@
+#pragma once
+
+#include "CubeState.h"
+#include "PackedCube.h"
+#include <string>
+#include <vector>
+
+// A move sequence compiled into the one permutation and orientation change it
+// performs. Applying it is a single CubeState::multiply however long the sequence is,
+// which pays off when the same scramble, macro or solution segment is applied to many
+// states.
+//
+// The move list is kept simplified: moves on the same axis next to each other are
+// combined per face, so R R becomes R2, R U U' R' disappears and U D U' becomes D.
+class Algorithm
+{
+public:
+    Algorithm(); // Empty sequence
+    explicit Algorithm(const std::vector<int>& moves);
+
+    // Standard notation with the same move names as RubiksCube::turn: faces U R F D L B,
+    // each optionally followed by 2 or ' ("2'" is also accepted). Spaces are optional.
+    // Returns false and leaves `algorithm` unchanged on anything else.
+    static bool parse(const std::string& notation, Algorithm& algorithm);
+
+    const std::vector<int>& moves() const { return sequence; }
+    const CubeState& effect() const { return permutation; } // The solved cube after the sequence
+    int length() const { return (int)sequence.size(); }
+    std::string toString() const;
+
+    Algorithm inverse() const;
+    Algorithm& append(int move);
+    Algorithm& append(const Algorithm& other);
+
+    void applyTo(CubeState& state) const { state.multiply(permutation); }
+    CubeState appliedTo(const CubeState& state) const;
+
+private:
+    std::vector<int> sequence;
+    CubeState permutation;
+};
+
+// Same as applying the algorithm to each cube, at the cost of a single move.
+void applyAlgorithm(PackedCube* cubes, int count, const Algorithm& algorithm);
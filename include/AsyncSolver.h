@@ -0,0 +1,105 @@
+#pragma once
+
+#include "CubeState.h"
+#include "SolutionCache.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TwoPhaseSolver;
+class OptimalSolver;
+class ThistlethwaiteSolver;
+
+// Runs solves on a background thread so the render loop never waits for one.
+//
+// request() hands a cube to the worker and returns at once; only the newest request
+// is kept, and starting one cancels whatever the worker was solving. Results go back
+// through a single atomic slot that poll() empties, so the render thread takes no lock
+// to collect them and runs each request's callback itself. Two-phase requests search
+// anytime and report every shorter solution as it turns up, followed by a final
+// result. cancel() stops the current search within microseconds and drops any result
+// still on its way. The solvers are constructed on the worker, so loading their
+// tables does not block the caller either. Finished solutions are cached (see
+// SolutionCache), so asking again for a position seen before, or a rotation, mirror
+// image or inverse of it, is answered at once. Thistlethwaite requests skip the cache:
+// they take microseconds, and are asked for their own, longer solutions.
+class AsyncSolver
+{
+public:
+    enum Method
+    {
+        TWO_PHASE,      // Anytime two-phase search within the time budget
+        OPTIMAL,        // Shortest solution, however long it takes (until cancelled)
+        THISTLETHWAITE, // Longer solution at once, from small tables
+    };
+
+    struct Result
+    {
+        uint64_t id;               // As returned by request()
+        CubeState cube;
+        std::vector<int> solution;
+        bool solved;
+        bool final;                // False for an improvement with more to come
+        double milliseconds;       // Since the worker started on the request
+    };
+
+    typedef std::function<void(const Result&)> Callback;
+
+    AsyncSolver();
+    ~AsyncSolver();
+
+    // Solves `cube` on the worker; `callback` runs in poll() for each of its results.
+    // `budgetMs` bounds a two-phase search and is ignored by the optimal one.
+    uint64_t request(const CubeState& cube, Method method, Callback callback, double budgetMs = 200.0);
+    void cancel();      // Abandons the current request, if any
+    bool busy() const;  // A request is queued or being solved
+
+    // Call from the thread that should run the callbacks, e.g. once per frame.
+    // Delivers the newest result of the current request, if there is one; returns
+    // whether a callback ran. Never blocks.
+    bool poll();
+
+private:
+    struct Request
+    {
+        uint64_t id;
+        CubeState cube;
+        Method method;
+        double budgetMs;
+        Callback callback;
+    };
+
+    struct Delivery
+    {
+        Result result;
+        Callback callback;
+    };
+
+    std::unique_ptr<TwoPhaseSolver> twoPhase;
+    std::unique_ptr<OptimalSolver> optimal;
+    std::unique_ptr<ThistlethwaiteSolver> thistlethwaite;
+    SolutionCache twoPhaseCache, optimalCache; // Optimal solutions also serve two-phase requests
+
+    // Worker input: the waiting request, taken under `mutex`, which the worker only
+    // holds long enough to swap it out.
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::unique_ptr<Request> next;
+    bool stopping;
+
+    std::atomic<uint64_t> currentId; // Newest request; results of older ones are dropped
+    std::atomic<bool> cancelSearch;  // Stops the worker's current search
+    std::atomic<bool> working;
+    std::atomic<Delivery*> ready;    // Newest undelivered result, swapped out by poll()
+
+    std::thread worker;
+
+    void run();
+    void solve(const Request& request);
+    void publish(const Request& request, Result& result);
+};
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "CubeState.h"
+#include "PackedCube.h"
+#include <array>
+
+// Integer coordinates of a CubeState used by the solvers. Each coordinate is 0 on the
+// solved cube, and each set* function builds a cube with that coordinate (other pieces
+// are left in a valid but unspecified arrangement).
+//
+// Everything here is constexpr: the move tables of the small coordinates below are
+// computed by the compiler and live in the binary's read-only data.
+
+const int N_TWIST = 2187;        // 3^7 corner orientations
+const int N_FLIP = 2048;         // 2^11 edge orientations
+const int N_SLICE = 495;         // C(12,4) positions of the UD-slice edges
+const int N_CORNER_PERM = 40320; // 8! corner permutations
+const int N_EDGE8_PERM = 40320;  // 8! permutations of the U/D edges (phase 2)
+const int N_SLICE_PERM = 24;     // 4! permutations of the UD-slice edges (phase 2)
+
+// C(n, k) for n up to 12, as Pascal's triangle.
+inline constexpr std::array<std::array<int, 13>, 13> binomials = [] {
+    std::array<std::array<int, 13>, 13> c{};
+    for (int n = 0; n <= 12; ++n) {
+        c[n][0] = 1;
+        for (int k = 1; k <= n; ++k) c[n][k] = c[n - 1][k - 1] + (k < n ? c[n - 1][k] : 0);
+    }
+    return c;
+}();
+
+inline constexpr int factorials[13] = {1, 1, 2, 6, 24, 120, 720, 5040, 40320, 362880, 3628800, 39916800, 479001600};
+
+constexpr int binomial(int n, int k) {
+    return k < 0 || k > n ? 0 : binomials[n][k];
+}
+
+// Lehmer-code rank of a permutation of 0..n-1 (0 for the identity) and its inverse.
+constexpr int rankPermutation(const uint8_t* perm, int n) {
+    int rank = 0;
+    for (int i = 0; i < n; ++i) {
+        int smaller = 0;
+        for (int j = i + 1; j < n; ++j)
+            if (perm[j] < perm[i]) ++smaller;
+        rank += smaller * factorials[n - 1 - i];
+    }
+    return rank;
+}
+
+constexpr void unrankPermutation(int rank, uint8_t* perm, int n) {
+    int used = 0;
+    for (int i = 0; i < n; ++i) {
+        int smaller = rank / factorials[n - 1 - i];
+        rank %= factorials[n - 1 - i];
+        for (int v = 0; v < n; ++v) {
+            if (used & (1 << v)) continue;
+            if (smaller-- == 0) {
+                perm[i] = (uint8_t)v;
+                used |= 1 << v;
+                break;
+            }
+        }
+    }
+}
+
+constexpr int getTwist(const CubeState& cube) {
+    int twist = 0;
+    for (int i = 0; i < 7; ++i) twist = twist * 3 + cube.cornerOrientation(i);
+    return twist;
+}
+
+constexpr int getFlip(const CubeState& cube) {
+    int flip = 0;
+    for (int i = 0; i < 11; ++i) flip = flip * 2 + cube.edgeOrientation(i);
+    return flip;
+}
+
+constexpr int getSlice(const CubeState& cube) {
+    int slice = 0, seen = 0;
+    for (int j = 11; j >= 0; --j) {
+        if (cube.edgePiece(j) >= CubeState::FR) {
+            slice += binomial(11 - j, seen + 1);
+            ++seen;
+        }
+    }
+    return slice;
+}
+
+constexpr int getCornerPerm(const CubeState& cube) {
+    uint8_t perm[8] = {};
+    for (int i = 0; i < 8; ++i) perm[i] = (uint8_t)cube.cornerPiece(i);
+    return rankPermutation(perm, 8);
+}
+
+// Only meaningful when the slice edges are in the slice
+constexpr int getEdge8Perm(const CubeState& cube) {
+    uint8_t perm[8] = {};
+    for (int i = 0; i < 8; ++i) perm[i] = (uint8_t)cube.edgePiece(i);
+    return rankPermutation(perm, 8);
+}
+
+// Same
+constexpr int getSlicePerm(const CubeState& cube) {
+    uint8_t perm[4] = {};
+    for (int i = 0; i < 4; ++i) perm[i] = (uint8_t)(cube.edgePiece(i + 8) - CubeState::FR);
+    return rankPermutation(perm, 4);
+}
+
+constexpr void setTwist(CubeState& cube, int twist) {
+    int sum = 0;
+    for (int i = 6; i >= 0; --i) {
+        int o = twist % 3;
+        twist /= 3;
+        sum += o;
+        cube.corners[i] = (uint8_t)(o << 4 | cube.cornerPiece(i));
+    }
+    cube.corners[7] = (uint8_t)(((3 - sum % 3) % 3) << 4 | cube.cornerPiece(7));
+}
+
+constexpr void setFlip(CubeState& cube, int flip) {
+    int sum = 0;
+    for (int i = 10; i >= 0; --i) {
+        int o = flip & 1;
+        flip >>= 1;
+        sum += o;
+        cube.edges[i] = (uint8_t)(o << 4 | cube.edgePiece(i));
+    }
+    cube.edges[11] = (uint8_t)((sum & 1) << 4 | cube.edgePiece(11));
+}
+
+constexpr void setSlice(CubeState& cube, int slice) {
+    int sliceEdge = CubeState::FR, otherEdge = CubeState::UR;
+    int remaining = 4;
+    for (int j = 0; j < 12; ++j) {
+        int c = binomial(11 - j, remaining);
+        if (remaining > 0 && slice >= c) {
+            slice -= c;
+            --remaining;
+            cube.edges[j] = (uint8_t)sliceEdge++;
+        } else {
+            cube.edges[j] = (uint8_t)otherEdge++;
+        }
+    }
+}
+
+constexpr void setCornerPerm(CubeState& cube, int perm) {
+    uint8_t p[8] = {};
+    unrankPermutation(perm, p, 8);
+    for (int i = 0; i < 8; ++i) cube.corners[i] = (uint8_t)((cube.corners[i] & 0xF0) | p[i]);
+}
+
+constexpr void setEdge8Perm(CubeState& cube, int perm) {
+    uint8_t p[8] = {};
+    unrankPermutation(perm, p, 8);
+    for (int i = 0; i < 8; ++i) cube.edges[i] = (uint8_t)((cube.edges[i] & 0xF0) | p[i]);
+}
+
+constexpr void setSlicePerm(CubeState& cube, int perm) {
+    uint8_t p[4] = {};
+    unrankPermutation(perm, p, 4);
+    for (int i = 0; i < 4; ++i) cube.edges[i + 8] = (uint8_t)((cube.edges[i + 8] & 0xF0) | (p[i] + CubeState::FR));
+}
+
+// Fills `table[c][m]` with the coordinate reached by applying move `moves[m]` to a cube
+// whose coordinate is `c`. For the large permutation coordinates, built at run time.
+// Each cube's children come from one expandMoves call: with the AVX2 kernel the corner
+// permutation table takes about 20 ms on one 2.1 GHz core, against 28 ms applying the
+// moves to CubeStates (cube_bench's corner_perm_move_table_* figures).
+template <class T, int M>
+void buildMoveTable(T (*table)[M], int size, const int* moves,
+                    void (*set)(CubeState&, int), int (*get)(const CubeState&)) {
+    PackedCube children[N_MOVES];
+    for (int c = 0; c < size; ++c) {
+        CubeState cube;
+        set(cube, c);
+        expandMoves(PackedCube(cube), children);
+        for (int m = 0; m < M; ++m) table[c][m] = (T)get(children[moves[m]].toState());
+    }
+}
+
+// A move table as plain arrays, which the compiler fills far faster than std::array.
+// table[c][m] reads as with the run-time tables.
+template <class T, int SIZE, int M = N_MOVES>
+struct MoveTable
+{
+    T move[SIZE][M];
+
+    constexpr const T* operator[](int c) const { return move[c]; }
+};
+
+// Same at compile time, for coordinates small enough to be worth the compiler's time.
+template <class T, int SIZE, int M>
+constexpr MoveTable<T, SIZE, M> makeMoveTable(const int (&moves)[M], void (*set)(CubeState&, int),
+                                              int (*get)(const CubeState&)) {
+    MoveTable<T, SIZE, M> table{};
+    for (int c = 0; c < SIZE; ++c) {
+        CubeState cube;
+        set(cube, c);
+        for (int m = 0; m < M; ++m) table.move[c][m] = (T)get(cube.applied(moves[m]));
+    }
+    return table;
+}
+
+// Orientation coordinates only need their digits moved, not a whole cube, which keeps
+// the compiler's work per table small: slot i takes the orientation of slot from[i]
+// plus delta[i], modulo `MOD`. The coordinate is the first SLOTS - 1 digits; the last
+// one makes the sum a multiple of MOD.
+template <int SIZE, int SLOTS, int MOD>
+constexpr MoveTable<uint16_t, SIZE> makeOrientationMoveTable(bool corners) {
+    int from[N_MOVES][SLOTS] = {}, delta[N_MOVES][SLOTS] = {};
+    for (int m = 0; m < N_MOVES; ++m) {
+        for (int i = 0; i < SLOTS; ++i) {
+            from[m][i] = corners ? cubieMoves[m].cp[i] : cubieMoves[m].ep[i];
+            delta[m][i] = (corners ? cubieMoves[m].co[i] : cubieMoves[m].eo[i]) >> 4;
+        }
+    }
+    MoveTable<uint16_t, SIZE> table{};
+    for (int c = 0; c < SIZE; ++c) {
+        int digits[SLOTS] = {}, sum = 0;
+        for (int i = SLOTS - 2, rest = c; i >= 0; --i, rest /= MOD) {
+            digits[i] = rest % MOD;
+            sum += digits[i];
+        }
+        digits[SLOTS - 1] = (MOD - sum % MOD) % MOD;
+        for (int m = 0; m < N_MOVES; ++m) {
+            int moved = 0;
+            for (int i = 0; i < SLOTS - 1; ++i) moved = moved * MOD + (digits[from[m][i]] + delta[m][i]) % MOD;
+            table.move[c][m] = (uint16_t)moved;
+        }
+    }
+    return table;
+}
+
+// The slice coordinate only depends on which slots hold slice edges.
+constexpr MoveTable<uint16_t, N_SLICE> makeSliceMoveTable() {
+    int from[N_MOVES][12] = {}, choose[12][5] = {};
+    for (int m = 0; m < N_MOVES; ++m)
+        for (int j = 0; j < 12; ++j) from[m][j] = cubieMoves[m].ep[j];
+    for (int n = 0; n < 12; ++n)
+        for (int k = 0; k <= 4; ++k) choose[n][k] = binomial(n, k);
+    MoveTable<uint16_t, N_SLICE> table{};
+    for (int c = 0; c < N_SLICE; ++c) {
+        bool occupied[12] = {};
+        for (int j = 0, rest = c, remaining = 4; j < 12; ++j) {
+            int k = choose[11 - j][remaining];
+            if (remaining > 0 && rest >= k) {
+                rest -= k;
+                --remaining;
+                occupied[j] = true;
+            }
+        }
+        for (int m = 0; m < N_MOVES; ++m) {
+            int slice = 0, seen = 0;
+            for (int j = 11; j >= 0; --j) {
+                if (occupied[from[m][j]]) {
+                    slice += choose[11 - j][seen + 1];
+                    ++seen;
+                }
+            }
+            table.move[c][m] = (uint16_t)slice;
+        }
+    }
+    return table;
+}
+
+inline constexpr int allMoves[N_MOVES] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17};
+
+// Orientation and slice coordinates under all 18 moves, computed at compile time
+// (Coordinates.cpp) so that one copy is shared through the page cache.
+extern const MoveTable<uint16_t, N_TWIST> twistMoveTable;
+extern const MoveTable<uint16_t, N_FLIP> flipMoveTable;
+extern const MoveTable<uint16_t, N_SLICE> sliceMoveTable;
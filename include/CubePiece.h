@@ -15,7 +15,9 @@ private:
     static bool s_resourcesInitialized;
 
 public:
-    glm::quat orientation; // Stores the piece's current orientation
+    // One of the 24 exact cube rotations (see CubieGeometry), so turns compose without
+    // drift and the model matrix is a table fetch.
+    int orientation;
     CubePiece();
     ~CubePiece(); 
     
@@ -24,10 +26,19 @@ public:
     static void cleanupSharedResources();
     
     void setupMesh();
-    void draw(Shader& shader);
-    void drawEdges(Shader& shader);
+
+    // Pieces are drawn instanced. The caller owns a VAO with the shared mesh bound
+    // through bindMeshAttributes() and a buffer of per-instance model matrices bound
+    // through bindInstanceAttributes(), and draws all its pieces with one call.
+    static const GLuint INSTANCE_MODEL_LOCATION = 2; // mat4 at locations 2 to 5
+    static void bindMeshAttributes();
+    static void bindInstanceAttributes(GLuint instanceVBO, GLsizei stride = sizeof(glm::mat4));
+    static void drawInstanced(GLsizei count);
+    static void drawEdgesInstanced(GLsizei count);
     
-    glm::mat4 get_model();
-    void update_orientation(glm::quat rotation_quat);
+    static const glm::mat4& rotationMatrix(int rotation);
+
+    const glm::mat4& get_model() const;
+    void update_orientation(int rotation); // Applies `rotation` after the current orientation
 
 };
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Shader.h"
+#include "CubeState.h"
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// Many static cubes on a grid, e.g. every state of a batch-solve run or every step of
+// a solution. These are not RubiksCube instances: a cube here has no pieces and does
+// not turn, it only shows a state's stickers. Each cube is one instance of a three-face mesh that the vertex shader
+// turns towards the camera, coloured from a buffer texture holding every cube's
+// stickers (one 32-bit word per face), so a frame costs three draw calls however many
+// cubes there are. Cubes outside the view frustum are culled on the CPU, and only
+// cubes nearer than the edge distance get the black sticker-edge lines.
+//
+// Cubes beyond the sprite distance are drawn as one point sprite each instead of six
+// triangles: each fragment intersects its view ray with the cube to find the face and
+// sticker, so sprites look the same as the mesh apart from taking one depth per cube.
+// Software rasterizers spend most of a wide view setting up tiny triangles, and this
+// cuts that work to a sixth.
+//
+// This is not an interactive-rate renderer on a software rasterizer. 10,000 cubes in
+// an 800x800 window on llvmpipe with one 2.1 GHz core take 23-28 ms a frame for the
+// whole grid and 20-23 ms close up, short of 60 FPS (16.7 ms); a sprite shader that
+// does nothing but write one colour already takes 14-17 ms there.
+//
+// Drawn with shaders/scene.vert and shaders/scene.frag, and the sprites with
+// shaders/scene_sprite.vert and shaders/scene_sprite.frag.
+class CubeScene
+{
+private:
+    struct Instance
+    {
+        float x, y, z;  // Center of the cube
+        uint32_t cube;  // Index into the facelet buffer
+    };
+
+    std::vector<CubeState> states;
+    std::vector<glm::vec3> positions;
+    std::vector<Instance> visible;    // Rebuilt each frame: cubes with edges, other meshes, sprites
+    std::vector<Instance> meshesOnly; // Scratch for cull()
+    int edgeInstances, meshInstances;
+    float edgeDistance, spriteDistance;
+
+    GLuint VAO, spriteVAO, meshVBO, instanceVBO, faceletBuffer, faceletTexture;
+    size_t instanceCapacity;
+    // Cubes whose stickers changed since the last upload, as a range; all of them when
+    // the buffer has to be reallocated.
+    size_t dirtyBegin, dirtyEnd;
+    bool faceletsReallocate;
+
+    // Uniform locations in the program they were looked up in
+    struct Uniforms
+    {
+        GLuint program;
+        GLint projection, view, cameraPos, facelets, isEdge, edgeColor, viewport, pixelRay;
+        void lookUp(Shader& shader);
+    } uniforms, spriteUniforms;
+
+    void uploadFacelets();
+    void cull(const glm::mat4& viewProjection, const glm::vec3& cameraPos);
+
+public:
+    static constexpr float CUBE_SIZE = 3.0f; // Same size as RubiksCube's 3x3x3 pieces
+    static constexpr float SPACING = 4.5f;   // Grid pitch
+
+    CubeScene();
+    ~CubeScene();
+
+    void setupMesh();   // Call while the GL context is current
+    void cleanupMesh(); // Likewise
+
+    void setStates(const std::vector<CubeState>& cubes); // Laid out row by row on the XZ plane
+    void setState(int index, const CubeState& cube);      // Only uploads the cubes that changed
+    int size() const;
+    glm::vec3 center() const;
+    float radius() const; // Of a sphere around the whole grid
+
+    // Cubes further than this from the camera are drawn without edge lines.
+    void setEdgeDistance(float distance);
+    // Cubes further than this are drawn as sprites, which never have edge lines. Points
+    // are at most 255 pixels wide on llvmpipe, which a cube stays under beyond about
+    // 30 units in a 1080-pixel-high window with a 45 degree field of view.
+    void setSpriteDistance(float distance);
+
+    void draw(Shader& shader, Shader& spriteShader, const glm::mat4& projection, const glm::mat4& view,
+              const glm::vec3& cameraPos);
+
+    // Of the last draw()
+    int visibleCount() const;
+    int edgeCount() const;
+    int spriteCount() const;
+};
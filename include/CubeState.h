@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Faces in the order used by the move numbering below.
+enum Face { FACE_U, FACE_R, FACE_F, FACE_D, FACE_L, FACE_B };
+
+// Moves are numbered face * 3 + (quarter turns - 1), so 0 = U, 1 = U2, 2 = U',
+// 3 = R, ... 17 = B'. Quarter turns are clockwise when looking at the face.
+const int N_MOVES = 18;
+
+constexpr int moveFace(int move) { return move / 3; }
+constexpr int movePower(int move) { return move % 3 + 1; }
+constexpr int makeMove(int face, int power) { return face * 3 + power - 1; }
+constexpr int inverseMove(int move) { return move - move % 3 + (2 - move % 3); }
+
+std::string moveName(int move);
+int parseMove(const std::string& name); // Returns -1 for an unknown name
+
+// Cubie-level cube state: which corner/edge sits in each slot and how it is twisted.
+// Slots follow the usual Kociemba order. Each byte stores (orientation << 4) | piece,
+// so the whole state is 20 bytes and applying a move is a fixed table lookup per byte.
+// Construction and moves are constexpr, so coordinate move tables built from them
+// can be computed at compile time (see Coordinates.h).
+struct CubeState
+{
+    enum Corner { URF, UFL, ULB, UBR, DFR, DLF, DBL, DRB };
+    enum Edge { UR, UF, UL, UB, DR, DF, DL, DB, FR, FL, BL, BR };
+
+    uint8_t corners[8];
+    uint8_t edges[12];
+
+    constexpr CubeState() : corners{0, 1, 2, 3, 4, 5, 6, 7}, edges{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11} {} // Solved cube
+
+    constexpr int cornerPiece(int slot) const { return corners[slot] & 0x0F; }
+    constexpr int cornerOrientation(int slot) const { return corners[slot] >> 4; }
+    constexpr int edgePiece(int slot) const { return edges[slot] & 0x0F; }
+    constexpr int edgeOrientation(int slot) const { return edges[slot] >> 4; }
+
+    constexpr void apply(int move);
+    constexpr CubeState applied(int move) const;
+
+    // this = this * other, i.e. the state reached by applying `other` after `this`.
+    void multiply(const CubeState& other);
+    CubeState inverse() const;
+
+    int cornerParity() const;
+    int edgeParity() const;
+    bool isSolved() const;
+    bool isValid() const; // Permutations, orientation sums and parities are consistent
+
+    bool operator==(const CubeState& other) const;
+    bool operator!=(const CubeState& other) const { return !(*this == other); }
+};
+
+// A move in "replaced by" form: slot i receives the piece from slot cp[i] (ep[i]) and
+// adds co[i] (eo[i]) to its orientation, pre-shifted into the high nibble.
+struct CubieMove
+{
+    uint8_t cp[8], co[8], ep[12], eo[12];
+};
+
+// All 18 moves, generated at compile time from the six clockwise face turns.
+constexpr std::array<CubieMove, N_MOVES> makeCubieMoves() {
+    constexpr CubieMove faceTurns[6] = {
+        // U
+        {{3, 0, 1, 2, 4, 5, 6, 7}, {0, 0, 0, 0, 0, 0, 0, 0},
+         {3, 0, 1, 2, 4, 5, 6, 7, 8, 9, 10, 11}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}},
+        // R
+        {{4, 1, 2, 0, 7, 5, 6, 3}, {2, 0, 0, 1, 1, 0, 0, 2},
+         {8, 1, 2, 3, 11, 5, 6, 7, 4, 9, 10, 0}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}},
+        // F
+        {{1, 5, 2, 3, 0, 4, 6, 7}, {1, 2, 0, 0, 2, 1, 0, 0},
+         {0, 9, 2, 3, 4, 8, 6, 7, 1, 5, 10, 11}, {0, 1, 0, 0, 0, 1, 0, 0, 1, 1, 0, 0}},
+        // D
+        {{0, 1, 2, 3, 5, 6, 7, 4}, {0, 0, 0, 0, 0, 0, 0, 0},
+         {0, 1, 2, 3, 5, 6, 7, 4, 8, 9, 10, 11}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}},
+        // L
+        {{0, 2, 6, 3, 4, 1, 5, 7}, {0, 1, 2, 0, 0, 2, 1, 0},
+         {0, 1, 10, 3, 4, 5, 9, 7, 8, 2, 6, 11}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}},
+        // B
+        {{0, 1, 3, 7, 4, 5, 2, 6}, {0, 0, 1, 2, 0, 0, 2, 1},
+         {0, 1, 2, 11, 4, 5, 6, 10, 8, 9, 3, 7}, {0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 1}},
+    };
+    std::array<CubieMove, N_MOVES> moves{};
+    for (int face = 0; face < 6; ++face) {
+        CubieMove acc{{0, 1, 2, 3, 4, 5, 6, 7}, {}, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}, {}};
+        const CubieMove& b = faceTurns[face];
+        for (int power = 0; power < 3; ++power) {
+            CubieMove next{};
+            for (int i = 0; i < 8; ++i) {
+                next.cp[i] = acc.cp[b.cp[i]];
+                next.co[i] = (uint8_t)((acc.co[b.cp[i]] + b.co[i]) % 3);
+            }
+            for (int i = 0; i < 12; ++i) {
+                next.ep[i] = acc.ep[b.ep[i]];
+                next.eo[i] = (uint8_t)((acc.eo[b.ep[i]] + b.eo[i]) % 2);
+            }
+            acc = next;
+            CubieMove& out = moves[face * 3 + power];
+            out = acc;
+            for (int i = 0; i < 8; ++i) out.co[i] = (uint8_t)(out.co[i] << 4);
+            for (int i = 0; i < 12; ++i) out.eo[i] = (uint8_t)(out.eo[i] << 4);
+        }
+    }
+    return moves;
+}
+
+inline constexpr std::array<CubieMove, N_MOVES> cubieMoves = makeCubieMoves();
+
+constexpr void CubeState::apply(int move) {
+    const CubieMove& m = cubieMoves[move];
+    uint8_t c[8] = {}, e[12] = {};
+    for (int i = 0; i < 8; ++i) {
+        uint8_t v = (uint8_t)(corners[m.cp[i]] + m.co[i]);
+        c[i] = v >= 0x30 ? (uint8_t)(v - 0x30) : v;
+    }
+    for (int i = 0; i < 12; ++i) e[i] = edges[m.ep[i]] ^ m.eo[i];
+    for (int i = 0; i < 8; ++i) corners[i] = c[i];
+    for (int i = 0; i < 12; ++i) edges[i] = e[i];
+}
+
+constexpr CubeState CubeState::applied(int move) const {
+    CubeState result = *this;
+    result.apply(move);
+    return result;
+}
+
+// Facelet strings: the 54 stickers in the order U1-U9, R1-R9, F1-F9, D1-D9, L1-L9,
+// B1-B9, each face read row by row from outside with U above F, R, L and B, and F
+// above D. The solved cube is "UUUUUUUUURRRRRRRRRFFFFFFFFFDDDDDDDDDLLLLLLLLLBBBBBBBBB".
+// Any six distinct characters may stand for the colours; each face's colour is taken
+// from its center sticker.
+bool parseFacelets(const std::string& facelets, CubeState& cube); // False unless a valid cube
+std::string toFacelets(const CubeState& cube);
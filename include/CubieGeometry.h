@@ -0,0 +1,26 @@
+#pragma once
+
+#include "CubeState.h"
+
+// Links the logical CubeState to the 3x3x3 grid drawn by RubiksCube.
+// Grid coordinates run 0..2 along x (L to R), y (D to U) and z (B to F).
+
+const int N_ROTATIONS = 24;
+
+// One of the 24 proper rotations of the cube, as a row-major integer 3x3 matrix.
+struct CubeRotation
+{
+    int m[9];
+};
+
+const CubeRotation& cubeRotation(int index); // index 0 is the identity
+
+// Index of the rotation a * b, i.e. b followed by a.
+int composeRotations(int a, int b);
+
+// Rotation of the pieces in the turning layer for a move (face * 3 + power - 1).
+int moveRotation(int move);
+
+// Rotation index of the cubie drawn at grid cell (x, y, z) in `state`.
+// Centers and the core never move under face turns and always return 0.
+int cubieRotation(const CubeState& state, int x, int y, int z);
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Shader.h"
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Where the viewer's frame time goes. Each frame records:
+//   - CPU time of the update, draw and swap sections, and of the whole frame
+//   - GPU time of the draw section, from a GL_TIME_ELAPSED query
+//   - draw calls and uniform uploads (RenderCounters) during the draw section
+//
+// GPU queries go round a ring of QUERY_RING query objects and are only read once
+// GL_QUERY_RESULT_AVAILABLE says so, a few frames later, so the CPU never waits for
+// the GPU; a frame whose slot is still busy goes without a GPU time.
+//
+// The last HISTORY frames are kept for percentiles, shown by drawOverlay() as a graph
+// in a corner of the window. openTrace() also writes every frame to a CSV file or, for
+// a .json path, to a Chrome trace (chrome://tracing, Perfetto).
+//
+// Call everything on the render thread, between setup() and cleanup().
+class FrameProfiler
+{
+public:
+    enum Metric { UPDATE, DRAW, SWAP, FRAME, GPU, N_METRICS };
+    static constexpr int HISTORY = 300;
+    static constexpr int QUERY_RING = 4;
+
+    struct Stats
+    {
+        float p50, p95, p99, max; // Milliseconds, 0 without samples
+        int samples;
+    };
+
+    FrameProfiler();
+    ~FrameProfiler();
+
+    void setup();   // Call while the GL context is current
+    void cleanup(); // Likewise, before it goes
+
+    // Starts writing frames to `path`: Chrome trace JSON if it ends in .json, else CSV.
+    bool openTrace(const std::string& path);
+    void closeTrace(); // Writes the frames still waiting for their GPU time
+
+    void beginFrame();
+    void begin(Metric section); // UPDATE, DRAW or SWAP; DRAW is also timed on the GPU
+    void end(Metric section);
+    void endFrame();
+
+    Stats stats(Metric metric) const; // Over the last HISTORY frames
+    std::string summary() const;      // Frame, CPU section and GPU percentiles in one line
+
+    // Frame times (white) and GPU times (green) of the last HISTORY frames, with their
+    // p50, p95 and p99 frame times and the 60 Hz budget as horizontal lines. Drawn with
+    // shaders/overlay.vert and shaders/overlay.frag.
+    void drawOverlay(Shader& shader, int viewportWidth, int viewportHeight);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Frame
+    {
+        uint64_t index;
+        double startMs;               // Since the profiler was created
+        float sectionStartMs[3];      // Since the frame started
+        float ms[N_METRICS];          // GPU is -1 until known, or if never measured
+        uint32_t drawCalls, uniformUploads;
+        bool gpuPending;
+    };
+
+    Clock::time_point origin, frameStart, sectionStart[3];
+    std::vector<Frame> history; // Ring indexed by frame index % HISTORY
+    uint64_t frameIndex;        // Of the current frame
+    uint64_t frameCount;        // Frames ended
+
+    // Timer queries in flight, with the frame each one measures
+    GLuint queries[QUERY_RING];
+    uint64_t queryFrame[QUERY_RING];
+    bool queryBusy[QUERY_RING];
+    int nextQuery;
+    int activeQuery; // Running during this frame's DRAW section, -1 if none
+    bool timerQueries;
+
+    FILE* trace;
+    bool traceJson;
+    bool firstTraceEvent;
+    uint64_t nextTraceFrame; // Oldest frame not written yet
+
+    GLuint overlayVAO, overlayVBO;
+    GLuint overlayProgram;
+    GLint colorLocation;
+    std::vector<glm::vec2> overlayVertices;
+    mutable std::vector<float> samples; // Scratch for stats()
+
+    Frame& frame(uint64_t index) { return history[index % HISTORY]; }
+    static float millisecondsBetween(Clock::time_point from, Clock::time_point to);
+    void collectQueries(bool wait);
+    void writeTrace(bool all);
+    void writeFrame(const Frame& f);
+    void finishTrace();
+};
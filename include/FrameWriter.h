@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Writes RGBA frames (bottom row first, as read back from OpenGL) as a video stream or
+// an image sequence:
+//   RAW  packed rgb24, top row first, frame after frame (ffmpeg -f rawvideo -pix_fmt rgb24)
+//   Y4M  YUV4MPEG2 with 4:2:0 BT.601 limited-range frames; width and height must be even
+//   PNG  one uncompressed PNG per frame
+// RAW and Y4M go to one file, or stdout for "-". PNG goes to a printf-style pattern
+// with the frame number (e.g. "frames/%05d.png"), or to stdout back to back for "-"
+// (ffmpeg -f image2pipe).
+class FrameWriter
+{
+public:
+    enum Format { RAW, Y4M, PNG };
+
+    FrameWriter(Format format, const std::string& path, int width, int height, int fps);
+    ~FrameWriter();
+
+    static bool parseFormat(const std::string& name, Format& format);
+
+    bool open(std::string& error);
+    bool write(const uint8_t* rgba); // False once output fails, e.g. a closed pipe
+    int frameCount() const { return frames; }
+
+private:
+    Format format;
+    std::string path;
+    int width, height, fps;
+    FILE* file;
+    bool ownsFile;
+    int frames;
+    std::vector<uint8_t> buffer; // Converted frame
+
+    void toRgb(const uint8_t* rgba);
+    void toYuv420(const uint8_t* rgba);
+    void toPng(const uint8_t* rgba);
+};
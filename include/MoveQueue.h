@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+// Unbounded lock-free queue of moves with any number of producers and one consumer.
+// Producers (input callbacks, a solver thread, a script) push from any thread without
+// blocking; the consumer, normally the render loop, pops from a single thread.
+//
+// It is a linked list in the style of Vyukov's MPSC queue: a push swaps itself in as
+// the new head with one atomic exchange and then links the previous head to it. A
+// sequence pushed at once is linked up privately first and stays contiguous.
+class MoveQueue
+{
+public:
+    MoveQueue();
+    ~MoveQueue();
+
+    MoveQueue(const MoveQueue&) = delete;
+    MoveQueue& operator=(const MoveQueue&) = delete;
+
+    void push(int move);
+    void push(const std::vector<int>& moves);
+
+    // Consumer side only. pop() can miss a push that has swapped in its node but not yet
+    // linked it; the move shows up on a later call.
+    bool pop(int& move);
+    void popAll(std::vector<int>& moves); // Appends everything available
+
+private:
+    struct Node
+    {
+        std::atomic<Node*> next;
+        int move;
+    };
+
+    std::atomic<Node*> head; // Last pushed node
+    Node* tail;              // Already consumed node whose successor is next
+};
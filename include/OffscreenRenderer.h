@@ -0,0 +1,52 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// OpenGL 3.3 core context with no window: a surfaceless EGL display (Mesa's
+// EGL_MESA_platform_surfaceless, else the default display with no surface), rendering
+// into a framebuffer object.
+//
+// Frames are read back asynchronously. endFrame() starts copying the frame into the
+// next pixel buffer object of a ring and hands over the oldest frame in the ring,
+// whose copy has had several frames' time to finish, so the CPU rarely waits for the
+// GPU. finish() hands over the frames still in flight. Pixels are RGBA, bottom row
+// first, as glReadPixels returns them.
+class OffscreenRenderer
+{
+public:
+    typedef std::function<void(const uint8_t* rgba)> FrameCallback;
+
+    OffscreenRenderer(int width, int height, int ringSize = 4);
+    ~OffscreenRenderer();
+
+    // Creates the context and makes it current on this thread. On failure, returns
+    // false with the reason in `error`.
+    bool initialize(std::string& error);
+
+    int width() const { return frameWidth; }
+    int height() const { return frameHeight; }
+
+    void beginFrame(); // Binds the framebuffer and sets the viewport
+    void endFrame(const FrameCallback& onFrame);
+    void finish(const FrameCallback& onFrame);
+
+private:
+    int frameWidth, frameHeight;
+    int ringSize;
+
+    EGLDisplay display;
+    EGLContext context;
+
+    GLuint framebuffer, colorBuffer, depthBuffer;
+    std::vector<GLuint> pixelBuffers;
+    std::vector<GLsync> fences;
+    int nextBuffer;  // Ring slot the next frame is read into
+    int inFlight;    // Frames read but not handed over yet
+
+    void deliver(int slot, const FrameCallback& onFrame);
+};
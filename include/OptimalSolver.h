@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Solver.h"
+#include "WorkStealingPool.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Finds shortest solutions in the half-turn metric with IDA* over the 18 face moves.
+// The heuristic is the maximum of three pattern databases (Korf): corners (8! * 3^7
+// entries) and two disjoint groups of six edges (12!/6! * 2^6 entries each, or two
+// overlapping groups of seven with setLargeEdgeTables), stored as distances modulo 3
+// at 2 bits per entry (PruningTable::MOD3): each node carries its exact distances, and
+// its children's are recovered from them. Every node is also looked up through the two
+// conjugates by the 120 degree rotation about the URF-DBL diagonal, which have the same
+// distance, so each database gives three bounds. The databases are shared and loaded
+// the first time a solver is constructed; generating them when no table files exist yet
+// (see PruningTable) takes on the order of a minute.
+// A solve fails if a database turns out to have no distance for the cube, which only
+// happens when a table file is corrupt (see PruningTable::setVerify).
+//
+// These databases are too weak for typical random states, which need 17 or 18 moves.
+// On one 2.1 GHz core the search expands about 4.5M nodes/s: 14-move positions take a
+// few seconds, 15-move ones one to two minutes, and each further move about 13 times
+// longer, so a typical random state takes hours. setLargeEdgeTables' databases (256 MB
+// instead of 21 MB, about eight minutes to generate) expand 4 to 6 times fewer nodes:
+// 14-move positions take 1 to 3 seconds and 15-move ones under ten, which still leaves
+// typical random states at tens of minutes or more. Seconds for those would take far
+// larger tables still.
+//
+// With more than one thread, each deep IDA* iteration is split into one task per
+// sequence of the first SPLIT_DEPTH moves, run on a work-stealing pool. The first task
+// to reach the goal proves the iteration's bound optimal and stops all the others.
+class OptimalSolver : public Solver
+{
+public:
+    explicit OptimalSolver(int threads = 1); // 0 uses every core
+
+    // Whether the databases are MOD3 (the default, 2 bits per entry) or PACKED4 (4 bits,
+    // no modulo per lookup). Only takes effect before the first solver is constructed.
+    static void setCompactTables(bool compact);
+    // Whether the edge databases cover two overlapping groups of seven edges (12!/5! * 2^7
+    // entries, 128 MB each as MOD3) rather than six. Likewise only before the first solver.
+    static void setLargeEdgeTables(bool large);
+
+    bool solve(const CubeState& cube, std::vector<int>& solution) override;
+    // Likewise, but gives up (returning false) soon after another thread sets `cancel`.
+    bool solve(const CubeState& cube, std::vector<int>& solution, const std::atomic<bool>* cancel);
+
+    uint64_t lastNodeCount() const { return nodes; } // Nodes expanded by the last solve
+    int threadCount() const { return pool ? pool->size() : 1; }
+
+private:
+    static const int MAX_DEPTH = 20;          // God's number
+    static const int N_VIEWS = 3;             // The position and its two diagonal conjugates
+    static const int SPLIT_DEPTH = 3;         // Moves fixed by each parallel task
+    static const int MIN_PARALLEL_BOUND = 11; // Shallower iterations finish too fast to split
+
+    // Search position: corner coordinates plus where each edge piece is, per view, and
+    // the exact pattern database distances its children's are recovered from.
+    struct Node
+    {
+        int cornerPerm[N_VIEWS];
+        int twist[N_VIEWS];
+        uint8_t edgeLocations[N_VIEWS][12]; // (orientation << 4) | slot of each edge piece
+        uint8_t cornerDistance[N_VIEWS];
+        uint8_t edgeDistance[N_VIEWS][2];
+    };
+
+    // One depth-first search: its moves so far and node count, plus the flag another
+    // search raises once it has found a solution of the current bound and the caller's
+    // cancel flag.
+    struct Search
+    {
+        int path[MAX_DEPTH];
+        uint64_t nodes;
+        int solutionLength;
+        const std::atomic<bool>* stop;
+        const std::atomic<bool>* cancel;
+    };
+
+    // Root of a parallel task: the position after its first moves.
+    struct Prefix
+    {
+        Node node;
+        int path[SPLIT_DEPTH];
+    };
+
+    std::unique_ptr<WorkStealingPool> pool;
+    uint64_t nodes;
+
+    static bool search(Search& s, const Node& node, int depth, int bound);
+    static void collectPrefixes(const Node& node, int depth, int bound, Prefix& prefix,
+                                std::vector<Prefix>& prefixes);
+    bool searchParallel(const Node& root, int bound, std::vector<int>& solution, const std::atomic<bool>* cancel);
+};
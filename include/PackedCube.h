@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CubeState.h"
+
+// CubeState laid out for byte shuffles: edges in bytes 0..11 and corners in bytes
+// 16..23 of one 32-byte block, each byte (orientation << 4) | piece as in CubeState,
+// the rest zero. Each half fits one 128-bit lane, so a move is a single in-lane byte
+// shuffle followed by an orientation add and a wrap (min of the sum and the sum minus
+// 0x20 for edges or 0x30 for corners).
+//
+// The kernels come in a scalar and an AVX2 version; the AVX2 one is used when the CPU
+// supports it, checked once at startup.
+struct alignas(32) PackedCube
+{
+    uint8_t bytes[32];
+
+    PackedCube(); // Solved cube
+    explicit PackedCube(const CubeState& state);
+
+    CubeState toState() const;
+
+    bool operator==(const PackedCube& other) const;
+    bool operator!=(const PackedCube& other) const { return !(*this == other); }
+};
+
+void applyMove(PackedCube& cube, int move);
+void applyMove(PackedCube* cubes, int count, int move); // Same move on every cube
+void expandMoves(const PackedCube& cube, PackedCube* children); // children[m] = cube after move m, all 18
+
+// cube * effect for every cube, as CubeState::multiply, at the cost of one move. Any
+// fixed sequence can be applied this way through the solved cube it produces.
+void applyPermutation(PackedCube* cubes, int count, const CubeState& effect);
+
+// Kernel selection, mainly for benchmarks: "avx2" or "scalar".
+const char* packedKernelName();
+bool usePackedKernel(const char* name); // False if unknown or unsupported on this CPU
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Distance-to-goal table over a coordinate space, in one of two encodings:
+//
+//   PACKED4  two 4-bit entries per byte, each the exact number of moves needed to
+//            reach the root coordinate
+//   MOD3     four 2-bit entries per byte, each that distance modulo 3. One move
+//            changes the distance by at most one, so a neighbour's three possible
+//            distances have three different residues: distance() recovers the exact
+//            value from the residue and the distance of the coordinate the search came
+//            from, and rootDistance() walks down to the root for the first one.
+//
+// Either way, a search asks distance(index, parentDistance) and gets the exact
+// distance; MOD3 halves the memory for a modulo per lookup.
+//
+// Tables can be saved once and then memory-mapped read-only, so startup cost does not
+// depend on table size and processes on one host share a single copy through the page
+// cache. File layout (little-endian):
+//
+//   offset  size  field
+//        0     8  magic "RCSPTBL\0"
+//        8     4  format version (FILE_VERSION)
+//       12     4  bits per entry: 4 (PACKED4) or 2 (MOD3)
+//       16     8  entry count
+//       24     8  payload size in bytes
+//       32     8  FNV-1a 64-bit hash of the payload
+//       40    64  layout name, NUL padded: which coordinates the index is built from
+//                 and in what order, e.g. "optimal/corners v1"
+//      104     -  zero padding up to HEADER_SIZE
+//     4096     -  payload: PACKED4 entry i in the low nibble of byte i/2 when i is
+//                 even, high nibble when odd; MOD3 entry i in bits 2*(i%4) and up of
+//                 byte i/4
+//
+// The header is a fixed 4 KiB, not the host's page size, so files are portable between
+// hosts; with 4 KiB pages that keeps the payload page aligned in the mapping.
+//
+// Loading checks the header but not the payload hash unless setVerify(true) is on:
+// hashing reads the whole file, which is the startup cost mapping avoids.
+class PruningTable
+{
+public:
+    enum Encoding { PACKED4, MOD3 };
+
+    static const int EMPTY = 0x0F;
+    static const int MOD3_EMPTY = 3;
+    static const uint32_t FILE_VERSION = 1;
+    static const int HEADER_SIZE = 4096;
+    static const uint64_t GENERATE_CHUNK = 1 << 16; // Entries per work item, a multiple of 8
+
+    PruningTable()
+        : entryCount(0), encoding(PACKED4), entries(nullptr), mapping(nullptr), mappingSize(0), expectedHash(0) {}
+    explicit PruningTable(uint64_t size);
+    ~PruningTable();
+
+    PruningTable(PruningTable&& other) noexcept;
+    PruningTable& operator=(PruningTable&& other) noexcept;
+    PruningTable(const PruningTable&) = delete;
+    PruningTable& operator=(const PruningTable&) = delete;
+
+    uint64_t size() const { return entryCount; }
+    bool isMapped() const { return mapping != nullptr; }
+    Encoding tableEncoding() const { return encoding; }
+    uint64_t payloadSize() const { return encoding == MOD3 ? (entryCount + 3) / 4 : (entryCount + 1) / 2; }
+
+    // The stored entry: the distance for PACKED4, the distance modulo 3 for MOD3.
+    int get(uint64_t index) const {
+        if (encoding == MOD3) return (entries[index >> 2] >> ((index & 3) << 1)) & 0x03;
+        return (entries[index >> 1] >> ((index & 1) << 2)) & 0x0F;
+    }
+
+    // Exact distance of `index`, one move away from a coordinate at `parentDistance`.
+    int distance(uint64_t index, int parentDistance) const {
+        if (encoding == PACKED4) return (entries[index >> 1] >> ((index & 1) << 2)) & 0x0F;
+        int residue = (entries[index >> 2] >> ((index & 3) << 1)) & 0x03;
+        // The one of parentDistance - 1, parentDistance and parentDistance + 1 with that residue
+        return parentDistance - 1 + (residue - parentDistance + 1 + 3 * 16) % 3;
+    }
+
+    // Exact distance of `index` with no parent to go by: for MOD3, the number of steps
+    // down to `root`, each to a neighbour one closer, i.e. with the residue below.
+    // Returns -1 if the table has no such path (an empty entry, a step with no
+    // neighbour below, or more steps than any table holds): the table is corrupt or
+    // does not belong to `root` and `neighbors`.
+    template <class Neighbors>
+    int rootDistance(uint64_t index, uint64_t root, Neighbors neighbors) const {
+        if (encoding == PACKED4) return get(index) == EMPTY ? -1 : get(index);
+        uint64_t out[32];
+        for (int steps = 0; steps < EMPTY; ++steps) {
+            if (index == root) return steps;
+            int residue = get(index);
+            if (residue == MOD3_EMPTY) return -1;
+            int below = (residue + 2) % 3;
+            int n = neighbors(index, out), k = 0;
+            while (k < n && get(out[k]) != below) ++k;
+            if (k == n) return -1;
+            index = out[k];
+        }
+        return -1;
+    }
+
+    // Only valid on PACKED4 tables that are not mapped from a file.
+    void set(uint64_t index, int value) {
+        uint8_t& byte = reinterpret_cast<uint8_t*>(owned.data())[index >> 1];
+        int shift = (int)(index & 1) << 2;
+        byte = (uint8_t)((byte & ~(0x0F << shift)) | (value << shift));
+    }
+
+    // Breadth-first fill from `root`, one depth at a time, on `threads` threads (0 uses
+    // every core). `neighbors(index, out)` writes the coordinates reachable from `index`
+    // in one move into `out` and returns how many it wrote; it is called concurrently.
+    //
+    // Early depths expand the frontier forward. Once the frontier outnumbers the
+    // entries still empty, each pass instead scans the empty entries backward for a
+    // neighbour on the frontier. Every entry's value is its BFS depth whichever way or
+    // order it is found, so the result does not depend on the thread count.
+    template <class Neighbors>
+    void generate(uint64_t root, Neighbors neighbors, int threads = 0) {
+        if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+        if (threads <= 0) threads = 1;
+        set(root, 0);
+        uint64_t filled = 1, frontier = 1;
+        for (int depth = 0; filled < entryCount && depth < EMPTY - 1; ++depth) {
+            bool backward = frontier > entryCount - filled;
+            std::atomic<uint64_t> nextChunk(0), added(0);
+            auto work = [&]() {
+                uint64_t out[32], count = 0;
+                for (;;) {
+                    uint64_t begin = nextChunk.fetch_add(GENERATE_CHUNK);
+                    if (begin >= entryCount) break;
+                    uint64_t end = std::min(begin + GENERATE_CHUNK, entryCount);
+                    for (uint64_t i = begin; i < end; ++i) {
+                        int value = loadEntry(i);
+                        if (backward) {
+                            if (value != EMPTY) continue;
+                            int n = neighbors(i, out);
+                            for (int k = 0; k < n; ++k) {
+                                if (loadEntry(out[k]) == depth) {
+                                    if (fillEntry(i, depth + 1)) ++count;
+                                    break;
+                                }
+                            }
+                        } else {
+                            if (value != depth) continue;
+                            int n = neighbors(i, out);
+                            for (int k = 0; k < n; ++k)
+                                if (fillEntry(out[k], depth + 1)) ++count;
+                        }
+                    }
+                }
+                added += count;
+            };
+            std::vector<std::thread> workers;
+            for (int t = 1; t < threads; ++t) workers.emplace_back(work);
+            work();
+            for (std::thread& worker : workers) worker.join();
+
+            if (added == 0) break;
+            frontier = added;
+            filled += added;
+        }
+    }
+
+    // A MOD3 copy of this PACKED4 table. Tables are generated at 4 bits per entry,
+    // where BFS depths are exact, and converted afterwards.
+    PruningTable toMod3() const;
+
+    // Maps the table `layout` from the table directory if a matching file exists,
+    // otherwise generates it and writes it there for the next run.
+    template <class Neighbors>
+    void loadOrGenerate(const std::string& layout, uint64_t size, uint64_t root, Neighbors neighbors,
+                        Encoding wanted = PACKED4) {
+        std::string path = filePath(layout);
+        if (!path.empty() && load(path, layout, size, wanted)) return;
+        *this = PruningTable(size);
+        generate(root, neighbors);
+        if (wanted == MOD3) *this = toMod3();
+        // Drop the private copy in favour of the shared mapping once it is on disk.
+        if (!path.empty() && save(path, layout)) load(path, layout, size, wanted);
+    }
+
+    bool save(const std::string& path, const std::string& layout) const;
+    bool load(const std::string& path, const std::string& layout, uint64_t expectedSize,
+              Encoding expectedEncoding = PACKED4);
+    bool verify() const; // Recomputes the payload hash of a mapped table
+
+    // When on, load() verifies each file it maps and rejects one whose payload does
+    // not match its hash, so loadOrGenerate rebuilds and rewrites it.
+    static void setVerify(bool verify);
+
+    // Where loadOrGenerate keeps its files: $CUBE_TABLE_DIR if set, else "tables".
+    // An empty directory disables saving and loading.
+    static void setDirectory(const std::string& directory);
+    static std::string filePath(const std::string& layout);
+
+private:
+    uint64_t entryCount;
+    Encoding encoding;
+    std::vector<uint32_t> owned; // Whole words, for the atomic updates in generate()
+    const uint8_t* entries;      // Points into `owned` or into the file mapping
+    void* mapping;
+    size_t mappingSize;
+    uint64_t expectedHash;
+
+    void unmap();
+
+    // Entry access during generation: entries are read and written as nibbles of
+    // 32-bit words with atomic operations, since neighbours share words across threads.
+    int loadEntry(uint64_t index) {
+        uint32_t word = __atomic_load_n(&owned[index >> 3], __ATOMIC_RELAXED);
+        return (word >> ((index & 7) << 2)) & 0x0F;
+    }
+
+    // Sets an EMPTY entry to `value` with a compare-and-swap on its word. Returns false
+    // if the entry was already filled.
+    bool fillEntry(uint64_t index, int value) {
+        uint32_t* word = &owned[index >> 3];
+        int shift = (int)(index & 7) << 2;
+        uint32_t current = __atomic_load_n(word, __ATOMIC_RELAXED);
+        for (;;) {
+            if (((current >> shift) & 0x0F) != EMPTY) return false;
+            uint32_t next = (current & ~(0x0Fu << shift)) | ((uint32_t)value << shift);
+            if (__atomic_compare_exchange_n(word, &current, next, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                return true;
+        }
+    }
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "CubeState.h"
+#include <cstddef>
+#include <cstdint>
+
+// Seedable, splittable random number stream (xoshiro256**). Streams built from the
+// same seed and stream number always produce the same numbers, and distinct stream
+// numbers give independent sequences, so parallel work can take one stream per chunk
+// and stay reproducible whatever the thread count.
+class RandomStream
+{
+public:
+    explicit RandomStream(uint64_t seed, uint64_t stream = 0);
+
+    uint64_t next();
+    uint32_t below(uint32_t bound); // Uniform in [0, bound), without modulo bias
+    uint64_t below64(uint64_t bound);
+
+    RandomStream split(); // A new independent stream, seeded from this one
+
+private:
+    uint64_t s[4];
+};
+
+// A state drawn uniformly from all 43,252,003,274,489,856,000 reachable cubes: the
+// ranks of both permutations and of all but the last corner twist and edge flip are
+// sampled directly, the last twist and flip are fixed by the orientation sums, and two
+// edges are swapped when the permutation parities differ (which pairs the states of
+// the two parities one to one, so the result stays uniform).
+CubeState randomState(RandomStream& rng);
+
+// Fills `out` with `count` uniform states in chunks of RANDOM_STATE_CHUNK, chunk k drawn
+// from RandomStream(seed, k), on `threads` threads (0 uses every core). The output
+// depends only on `seed`.
+const size_t RANDOM_STATE_CHUNK = 4096;
+void randomStates(CubeState* out, size_t count, uint64_t seed, int threads = 0);
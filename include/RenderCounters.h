@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+// Per-frame counts of GL work, bumped by the renderers and Shader's setters on the
+// render thread, and read and reset once a frame by FrameProfiler.
+struct RenderCounters
+{
+    static inline uint32_t drawCalls = 0;
+    static inline uint32_t uniformUploads = 0;
+
+    static void reset()
+    {
+        drawCalls = 0;
+        uniformUploads = 0;
+    }
+};
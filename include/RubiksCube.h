@@ -4,6 +4,11 @@
 #include <string>
 #include "Shader.h"
 #include "CubePiece.h"
+#include "CubeState.h"
+#include "MoveQueue.h"
+#include "Algorithm.h"
+#include <atomic>
+#include <deque>
 
 
 
@@ -23,22 +28,67 @@ private:
     std::vector<std::vector<int>> sides;
     std::vector<std::vector<std::vector<CubePiece>>> cubePieces;
 
+    // Logical state of the cube; cubePieces only mirrors it for rendering
+    CubeState state;
+
+    // Moves waiting to be played. Producers push to `moveQueue` from any thread; the
+    // render thread moves them to `pendingMoves`, merging same-face moves if enabled.
+    MoveQueue moveQueue;
+    std::deque<int> pendingMoves;
+    std::vector<int> incomingMoves; // Scratch for draining moveQueue
+    std::atomic<bool> mergeMoves;
+    std::atomic<bool> instantMode;
+    std::atomic<float> playbackSpeed; // Multiplier of animationSpeedRad
+
     // Animation state
     bool isAnimating;
     float currentAnimationAngleRad; // Current angle in radians
-    float frameAddedAngle;
-    float targetAnimationAngleRad;  // Target angle in radians (pi/2)
-    float animationSpeedRad;        // Radians per second
+    float targetAnimationAngleRad;  // pi/2, or pi for half turns
+    float animationSpeedRad;        // Radians per second at playback speed 1
     glm::vec3 animationWorldAxis;   // Axis of rotation in world space
     int animatingLayerIndex;        // 0, 1, or 2
     char animatingFacePlane;        // 'X', 'Y', or 'Z' (plane normal to rotation axis)
-    bool animationIsClockwise;      // Direction of logical turn
+    bool animationIsClockwise;      // Visual rotation is positive around animationWorldAxis
+    int animatingMove;              // Move applied to `state` once the animation ends
+
+    void takeQueuedMoves();
+    void startAnimation(int move);
+    void syncPieces(); // Copies piece orientations from `state`
+
+    // Instanced rendering: one model matrix per piece in instanceVBO, drawn with a
+    // single call. Instances are ordered so the animating layer is the last nine,
+    // and only those are uploaded while a turn animates.
+    static const int N_PIECES = 27;
+    static const int LAYER_PIECES = 9;
+    GLuint instanceVAO, instanceVBO;
+    glm::mat4 instanceModels[N_PIECES];
+    int instanceCell[N_PIECES]; // Grid cell i * 9 + j * 3 + k drawn by each instance
+    bool instancesDirty;        // Order or resting orientations changed: upload all
+
+    bool inAnimatingLayer(int cell) const;
+    glm::mat4 pieceModel(int cell) const; // Including the current turn animation
 
 public:
     RubiksCube();
     ~RubiksCube();
     void setupMesh();
+    void cleanupMesh(); // Frees the instance buffers; call while the GL context is current
     void draw(Shader& shader);
-    void turn(std::string moveName, bool clockwise); // Changed int to bool
-    void update(float deltaTime); // For animation
+    void turn(std::string moveName, bool clockwise); // Queues the move; Shift (clockwise) gives the inverse
+    void update(float deltaTime); // Plays queued moves
+    const CubeState& getState() const;
+    CubeState getTargetState(); // Render thread only: the state once every queued move has played
+
+    // Thread-safe: any thread may queue moves or change how they are played.
+    void queueMove(int move);
+    void queueMoves(const std::vector<int>& moves);
+    void queueAlgorithm(const Algorithm& algorithm); // Its simplified moves
+    bool queueAlgorithm(const std::string& notation); // False if the notation does not parse
+    void setMergeMoves(bool merge);   // Combine consecutive moves of the same face, e.g. R R -> R2, R R' -> nothing
+    void setInstantMode(bool instant); // Apply everything queued at the next update, without animation
+    void setPlaybackSpeed(float speed); // 1 is a quarter turn in half a second
+    float getPlaybackSpeed() const;
+    bool getInstantMode() const;
+
+    bool isIdle(); // Render thread only: nothing animating or queued
 };
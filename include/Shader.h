@@ -1,11 +1,19 @@
 #pragma once
 
 #include <GL/glew.h> // include glad to get all the required OpenGL headers
+#include "RenderCounters.h"
   
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp> // For glm::value_ptr
 
@@ -46,9 +54,88 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
         }
+        // 2. reuse the program linked on a previous run when the driver can load it
+        std::string cachePath = binaryCachePath(vertexCode, fragmentCode);
+        ID = glCreateProgram();
+        if (!loadBinary(cachePath)) {
+            compileAndLink(vertexCode, fragmentCode);
+            saveBinary(cachePath);
+        }
+        // 3. look every uniform up once, for lookUpLocation
+        cacheUniformLocations();
+    }
+
+    // Where linked programs are cached: $CUBE_SHADER_CACHE if set, else "shader_cache".
+    // An empty directory disables the cache.
+    static std::string& cacheDirectory()
+    {
+        static std::string directory = [] {
+            const char* env = std::getenv("CUBE_SHADER_CACHE");
+            return std::string(env ? env : "shader_cache");
+        }();
+        return directory;
+    }
+
+    void use() { 
+        glUseProgram(ID);
+    }
+
+    // Location of an active uniform, -1 (ignored by the setters) if there is none.
+    // A hash lookup, so for setup only: renderers keep the locations they need and
+    // pass them to the setters below, which take nothing else.
+    GLint lookUpLocation(const std::string &name) const
+    {
+        auto it = uniformLocations.find(name);
+        return it == uniformLocations.end() ? -1 : it->second;
+    }
+
+    void setBool(GLint location, bool value) const
+    {         
+        glUniform1i(location, (int)value);
+        ++RenderCounters::uniformUploads; 
+    }
+    void setInt(GLint location, int value) const
+    { 
+        glUniform1i(location, value);
+        ++RenderCounters::uniformUploads; 
+    }
+    void setFloat(GLint location, float value) const
+    { 
+        glUniform1f(location, value);
+        ++RenderCounters::uniformUploads; 
+    }
+
+    void setVec3(GLint location, const glm::vec3 &value) const
+    {
+        glUniform3fv(location, 1, &value[0]);
+        ++RenderCounters::uniformUploads;
+    }
+
+    void setVec4(GLint location, const glm::vec4 &value) const
+    {
+        glUniform4fv(location, 1, &value[0]);
+        ++RenderCounters::uniformUploads;
+    }
+
+    void setMat3(GLint location, const glm::mat3 &mat) const
+    {
+        glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(mat));
+        ++RenderCounters::uniformUploads;
+    }
+
+    void setMat4(GLint location, const glm::mat4 &mat) const
+    {
+        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat));
+        ++RenderCounters::uniformUploads;
+    }
+
+private:
+    std::unordered_map<std::string, GLint> uniformLocations;
+
+    void compileAndLink(const std::string &vertexCode, const std::string &fragmentCode)
+    {
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
         unsigned int vertex, fragment;
         // vertex shader
         vertex = glCreateShader(GL_VERTEX_SHADER);
@@ -61,49 +148,121 @@ public:
         glCompileShader(fragment);
         checkCompileErrors(fragment, "FRAGMENT");
         // shader Program
-        ID = glCreateProgram();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
+        if (binaryFormatCount() > 0)
+            glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
         // delete the shaders as they're linked into our program now and no longer necessary
+        glDetachShader(ID, vertex);
+        glDetachShader(ID, fragment);
         glDeleteShader(vertex);
         glDeleteShader(fragment);
-
-    }
-    void use() { 
-        glUseProgram(ID);
     }
 
-    void setBool(const std::string &name, bool value) const
-    {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    void cacheUniformLocations()
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<char> name(maxLength + 1);
+        for (GLint i = 0; i < count; ++i) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, name.data());
+            std::string uniform(name.data(), length);
+            GLint location = glGetUniformLocation(ID, uniform.c_str());
+            uniformLocations[uniform] = location;
+            // Arrays are reported as "name[0]"; also accept the plain name
+            if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+                uniformLocations[uniform.substr(0, uniform.size() - 3)] = location;
+        }
     }
-    void setInt(const std::string &name, int value) const
-    { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+
+    // Program binaries need GL 4.1 or ARB_get_program_binary; without them the query
+    // fails and leaves the count at zero.
+    static GLint binaryFormatCount()
+    {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        while (glGetError() != GL_NO_ERROR) {}
+        return formats;
     }
-    void setFloat(const std::string &name, float value) const
-    { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+
+    static uint64_t fnv1a(const std::string &data, uint64_t hash = 0xcbf29ce484222325ULL)
+    {
+        for (unsigned char c : data) {
+            hash ^= c;
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
     }
 
-    void setVec4(const std::string &name, const glm::vec4 &value) const
+    // One file per pair of sources and driver, so editing a shader or updating the
+    // driver just misses the cache.
+    static std::string binaryCachePath(const std::string &vertexCode, const std::string &fragmentCode)
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        const std::string &directory = cacheDirectory();
+        if (directory.empty() || binaryFormatCount() == 0) return "";
+        uint64_t hash = fnv1a(vertexCode);
+        hash = fnv1a(std::string(1, '\0') + fragmentCode, hash);
+        for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+            const GLubyte* value = glGetString(name);
+            hash = fnv1a(std::string(1, '\0') + (value ? (const char*)value : ""), hash);
+        }
+        char file[32];
+        std::snprintf(file, sizeof(file), "/%016llx.bin", (unsigned long long)hash);
+        return directory + file;
     }
 
-    void setVec4(const std::string &name, float x, float y, float z, float w) const
+    // File layout: the GLenum binary format, then the binary.
+    bool loadBinary(const std::string &path)
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        if (path.empty()) return false;
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) return false;
+        std::streamoff size = static_cast<std::streamoff>(file.tellg()) - (std::streamoff)sizeof(GLenum);
+        if (size <= 0) return false;
+        file.seekg(0);
+        GLenum format = 0;
+        std::vector<char> binary(size);
+        file.read(reinterpret_cast<char*>(&format), sizeof(format));
+        file.read(binary.data(), size);
+        if (!file) return false;
+        glProgramBinary(ID, format, binary.data(), (GLsizei)binary.size());
+        GLint success = 0;
+        glGetProgramiv(ID, GL_LINK_STATUS, &success);
+        return success != 0; // A rejected binary leaves the program ready for a fresh link
     }
 
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    void saveBinary(const std::string &path) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+        if (path.empty()) return;
+        GLint success = 0, length = 0;
+        glGetProgramiv(ID, GL_LINK_STATUS, &success);
+        glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (!success || length <= 0) return;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(ID, length, &length, &format, binary.data());
+
+        mkdir(cacheDirectory().c_str(), 0755);
+        // Write under a temporary name and rename, so other instances never load half a file
+        std::string temporary = path + ".tmp" + std::to_string(getpid());
+        {
+            std::ofstream file(temporary, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+            file.write(binary.data(), length);
+            if (!file) {
+                std::remove(temporary.c_str());
+                return;
+            }
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) std::remove(temporary.c_str());
     }
 
-private:
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(unsigned int shader, std::string type)
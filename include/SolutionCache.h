@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CubeState.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Bounded cache of solutions, shared by any number of threads.
+//
+// A position, its 47 other symmetry conjugates and the inverses of all 48 are solved
+// by the same moves up to conjugation and reversal, so they share one entry. The entry
+// is keyed by the smallest of these 96 states. On a hit the stored solution is
+// translated back through the symmetry (and inverted if needed) that relates the asked
+// position to it. Entries are spread over shards by key hash, each shard with its own
+// lock and least-recently-used eviction, so threads rarely wait on each other.
+class SolutionCache
+{
+public:
+    explicit SolutionCache(size_t capacity = 1 << 16); // Entries over all shards; 0 disables
+
+    // Fills `solution` and returns true if an equivalent position was stored.
+    bool lookup(const CubeState& cube, std::vector<int>& solution);
+    // Stores `solution` for `cube`, keeping the shorter one if there already is one.
+    void store(const CubeState& cube, const std::vector<int>& solution);
+
+    size_t size() const;
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+    // The representative of the position's symmetry/inverse class, and its hash.
+    struct Canonical
+    {
+        CubeState state;
+        int sym;       // state = S * cube * S^-1 (or of cube^-1) for this symmetry
+        bool inverted; // Taken from cube^-1
+        uint64_t hash;
+    };
+    static Canonical canonical(const CubeState& cube);
+
+private:
+    static const int N_SHARDS = 16;
+
+    struct Entry
+    {
+        CubeState state; // The representative, compared on lookup so hash collisions miss
+        std::vector<int> solution;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::list<std::pair<uint64_t, Entry>> entries; // Most recently used first
+        std::unordered_map<uint64_t, std::list<std::pair<uint64_t, Entry>>::iterator> index;
+        uint64_t hits = 0, misses = 0;
+    };
+
+    size_t shardCapacity;
+    std::unique_ptr<Shard[]> shards;
+
+    Shard& shardOf(uint64_t hash) { return shards[hash % N_SHARDS]; }
+};
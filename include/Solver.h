@@ -0,0 +1,24 @@
+#pragma once
+
+#include "CubeState.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Common interface of the cube solvers, so callers can pick one at runtime.
+class Solver
+{
+public:
+    virtual ~Solver() {}
+
+    // Fills `solution` with moves (see CubeState.h for the numbering) that solve `cube`.
+    // Returns false if `cube` is not a valid state or the solver gave up.
+    virtual bool solve(const CubeState& cube, std::vector<int>& solution) = 0;
+};
+
+// A solver by name, with its default settings, or null for an unknown name:
+//   "two-phase"       TwoPhaseSolver: near-optimal solutions in milliseconds, ~126 MB of tables
+//   "optimal"         OptimalSolver: shortest solutions, slow beyond ~14 moves, ~43 MB of tables
+//   "thistlethwaite"  ThistlethwaiteSolver: ~31 moves in microseconds, under 2 MB of tables
+// Tables are set up by the first solver of each kind, as with the constructors.
+std::unique_ptr<Solver> createSolver(const std::string& name);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Coordinates.h"
+#include <vector>
+
+// Symmetries of the cube and symmetry-reduced ("sym") coordinates.
+//
+// The 48 symmetries are numbered 16 * urf3 + 8 * f2 + 2 * u4 + lr2, composed from a
+// 120 degree turn about the URF-DBL diagonal, a half turn about the F-B axis, a quarter
+// turn about the U-D axis and the reflection swapping L and R. The first N_SYM_UD keep
+// the UD axis in place, so they map the phase 2 subgroup of the two-phase solver onto
+// itself.
+//
+// A sym coordinate replaces a raw coordinate by its class under conjugation with the
+// UD symmetries plus the symmetry that takes it to the class representative. Tables
+// indexed by class instead of raw value are about 16 times smaller and give the same
+// distances, since conjugate positions are equally far from solved.
+
+const int N_SYM = 48;
+const int N_SYM_UD = 16;
+const int N_FLIPSLICE = N_FLIP * N_SLICE;  // Raw flipslice = flip * N_SLICE + slice
+const int N_FLIPSLICE_CLASS = 64430;
+const int N_CORNER_CLASS = 2768;
+
+// S * cube * S^-1 for symmetry S = `sym`. Mirror symmetries give a mirrored position,
+// still a legal cube.
+CubeState conjugate(const CubeState& cube, int sym);
+
+struct SymmetryTables
+{
+    int inverse[N_SYM];
+    int conjugateMove[N_SYM][N_MOVES]; // S * move * S^-1 is again a single move
+
+    // Conjugates of raw coordinates by the UD symmetries; each depends on that
+    // coordinate only. edge8Conjugate is only meaningful within the phase 2 subgroup.
+    uint16_t twistConjugate[N_TWIST][N_SYM_UD];
+    uint16_t edge8Conjugate[N_EDGE8_PERM][N_SYM_UD];
+
+    // For raw x: conjugating by sym[x] turns x into rep[class[x]].
+    std::vector<uint16_t> flipSliceClass;
+    std::vector<uint8_t> flipSliceSym;
+    std::vector<uint32_t> flipSliceRep;
+    uint16_t cornerClass[N_CORNER_PERM];
+    uint8_t cornerSym[N_CORNER_PERM];
+    uint16_t cornerRep[N_CORNER_CLASS];
+};
+
+// Shared tables, built on first use (well under a second).
+const SymmetryTables& symmetryTables();
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Solver.h"
+#include <cstddef>
+
+// Thistlethwaite's four-phase algorithm, for when memory and startup time matter more
+// than solution length. Each phase takes the cube into a smaller subgroup, using only
+// moves of the one it is in:
+//
+//   phase 1  all moves               -> <U, D, R, L, F2, B2>     edges oriented
+//   phase 2  <U, D, R, L, F2, B2>    -> <U, D, R2, L2, F2, B2>   corners oriented, UD-slice
+//                                                                edges in the slice
+//   phase 3  <U, D, R2, L2, F2, B2>  -> <U2, D2, R2, L2, F2, B2> corners in a permutation of
+//                                                                the half-turn group, M-slice
+//                                                                edges in the M slice
+//   phase 4  <U2, D2, R2, L2, F2, B2> -> solved
+//
+// Every phase has a table of exact distances over its coordinates, so it is solved by
+// walking down the table, one lookup per move and no search: a solve takes a few
+// microseconds and gives about 31 moves on average, never more than MAX_LENGTH
+// (7 + 10 + 13 + 15). The tables take under 2 MB in all and are built in memory in a few
+// tens of milliseconds the first time a solver is constructed; nothing is read from or
+// written to the table directory. A solver holds no state of its own, so one can be
+// shared between threads.
+class ThistlethwaiteSolver : public Solver
+{
+public:
+    static const int MAX_LENGTH = 45;
+
+    ThistlethwaiteSolver();
+
+    bool solve(const CubeState& cube, std::vector<int>& solution) override;
+
+    static size_t tableBytes(); // Memory held by the shared tables
+};
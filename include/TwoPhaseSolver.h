@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Solver.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+// Kociemba's two-phase algorithm. Phase 1 brings the cube into the subgroup
+// <U, D, R2, L2, F2, B2> (orientations solved, UD-slice edges in the slice), phase 2
+// finishes it with those moves only. Phase 1 is pruned with its exact distance and
+// phase 2 with corner/edge bounds, both from tables reduced by the 16 UD symmetries
+// (see Symmetry.h) to about 126 MB in total. Move and pruning tables are shared by
+// all instances and set up the first time a solver is constructed, with the pruning
+// tables mapped from the table directory when present (see PruningTable). A solver
+// instance only holds search scratch space, so use one per thread.
+class TwoPhaseSolver : public Solver
+{
+public:
+    static const int DEFAULT_MAX_LENGTH = 22;
+
+    TwoPhaseSolver();
+
+    bool solve(const CubeState& cube, std::vector<int>& solution) override;
+
+    // Fills `solution` with at most `maxLength` moves solving `cube`.
+    // Returns false if `cube` is not a valid state or no such solution was found.
+    bool solve(const CubeState& cube, std::vector<int>& solution, int maxLength);
+
+    // Limits for solveAnytime(); default constructed it is unlimited.
+    struct Budget
+    {
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        uint64_t maxNodes = UINT64_MAX;
+        const std::atomic<bool>* cancel = nullptr; // Another thread may set it to stop the search
+
+        static Budget milliseconds(double ms);
+        static Budget nodes(uint64_t count);
+    };
+
+    // Anytime search: finds a first solution as quickly as solve() does, then keeps
+    // searching deeper phase 1 paths for shorter ones until the budget runs out or no
+    // phase 1 depth below the best length is left. Each shorter solution is passed to
+    // `improved` (if set) as soon as it is found, and `solution` ends up holding the
+    // best. The budget is checked every few hundred nodes, so the solver stops within
+    // microseconds of the deadline. Returns false if no solution was found in time.
+    bool solveAnytime(const CubeState& cube, std::vector<int>& solution, const Budget& budget,
+                      const std::function<void(const std::vector<int>&)>& improved = nullptr);
+
+    uint64_t lastNodeCount() const { return nodes; } // Nodes visited by the last solve
+    bool lastSolveExhausted() const { return !stopped; } // False if the budget cut it short
+
+private:
+    static const int MAX_DEPTH = 31;
+    static const uint64_t BUDGET_CHECK_INTERVAL = 256; // Nodes between deadline checks
+
+    CubeState start;
+    int maxLength;
+    int solutionLength;
+    int path[MAX_DEPTH];
+    bool found;
+
+    // Anytime state: keep going after a solution, and the limits that end the search.
+    bool anytime;
+    bool stopped;
+    uint64_t nodes;
+    uint64_t nextBudgetCheck;
+    Budget budget;
+    const std::function<void(const std::vector<int>&)>* improved;
+    std::vector<int>* best;
+
+    bool search(const CubeState& cube);
+    bool outOfBudget();
+    // Each returns true once the whole search should end: a solution was found and
+    // this is not an anytime search, or the budget ran out.
+    bool searchPhase1(int twist, int flip, int slice, int depth, int togo);
+    bool startPhase2(int depth);
+    bool searchPhase2(int cornerPerm, int edge8Perm, int slicePerm, int depth, int togo);
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task deque. Submitted tasks are dealt
+// round-robin; a worker runs its newest task first and, when its deque is empty, steals
+// the oldest task of another worker.
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(int threads = 0); // 0 uses every core
+    ~WorkStealingPool();
+
+    int size() const { return (int)workers.size(); }
+
+    void submit(std::function<void()> task);
+    void wait(); // Blocks until every submitted task has finished
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<unsigned> nextQueue;
+
+    std::mutex stateMutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    int queued;   // Tasks sitting in a deque
+    int pending;  // Tasks submitted but not finished
+    bool stopping;
+
+    bool take(int self, std::function<void()>& task);
+    void run(int self);
+};
@@ -0,0 +1,10 @@
+#version 330 core
+
+out vec4 FragColor;
+
+uniform vec4 u_color;
+
+void main()
+{
+    FragColor = u_color;
+}
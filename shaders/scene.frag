@@ -0,0 +1,26 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 sticker;
+flat in uint stickers;
+
+uniform bool u_isEdge;
+uniform vec4 u_edgeColor;
+
+// Same colours as the single-cube viewer (white, blue, red, yellow, green, orange for
+// U, R, F, D, L, B), two bits per channel per face: a constant array indexed per
+// fragment costs llvmpipe more than the whole rest of this shader.
+const uvec3 FACE_COLORS = uvec3(0x8a2u, 0x682u, 0x00au);
+
+void main()
+{
+    if (u_isEdge) {
+        FragColor = u_edgeColor;
+        return;
+    }
+
+    ivec2 rc = clamp(ivec2(sticker), 0, 2);
+    uint colour = (stickers >> uint(3 * (rc.x * 3 + rc.y))) & 7u;
+    FragColor = vec4(vec3((FACE_COLORS >> (colour * 2u)) & 3u) * 0.5, 1.0);
+}
@@ -0,0 +1,39 @@
+#version 330 core
+layout (location = 0) in vec4 aPosFace;  // position on the +x, +y or +z face, axis 0..2 in w (-1 for edge lines)
+layout (location = 1) in vec3 aOffset;   // per cube: center in the scene
+layout (location = 2) in uint aCube;     // per cube: index into the facelet buffer
+
+out vec2 sticker;        // row and column on the face, 0 to 3
+flat out uint stickers;  // colours of the face's nine stickers, 3 bits each
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 cameraPos;
+uniform usamplerBuffer u_facelets; // per cube, one word per face in URFDLB order
+
+void main()
+{
+    // Mirror the mesh onto the three faces turned towards the camera.
+    vec3 side = step(aOffset, cameraPos) * 2.0 - 1.0;
+    vec3 pos = aPosFace.xyz * side;
+
+    // Each face read from outside as in the facelet string: U above F, R, L and B,
+    // F above D.
+    vec3 p = pos + 1.5;
+    vec3 q = 1.5 - pos;
+    int axis = int(aPosFace.w);
+    int face = 0;
+    if (axis == 0) {
+        face = side.x > 0.0 ? 1 : 4;                             // R or L
+        sticker = side.x > 0.0 ? vec2(q.y, q.z) : vec2(q.y, p.z);
+    } else if (axis == 1) {
+        face = side.y > 0.0 ? 0 : 3;                             // U or D
+        sticker = side.y > 0.0 ? vec2(p.z, p.x) : vec2(q.z, p.x);
+    } else {
+        face = side.z > 0.0 ? 2 : 5;                             // F or B
+        sticker = side.z > 0.0 ? vec2(q.y, p.x) : vec2(q.y, q.x);
+    }
+    stickers = texelFetch(u_facelets, int(aCube) * 6 + face).r;
+
+    gl_Position = projection * view * vec4(pos + aOffset, 1.0);
+}
@@ -0,0 +1,45 @@
+#version 330 core
+
+out vec4 FragColor;
+
+flat in vec3 center;
+flat in vec3 side;
+flat in uvec3 stickers;
+
+uniform mat3 u_pixelRay; // window position (x, y, 1) to the world direction of its view ray
+
+// Same colours as scene.frag
+const uvec3 FACE_COLORS = uvec3(0x8a2u, 0x682u, 0x00au);
+
+void main()
+{
+    // Slab test of the view ray against the cube: it enters through the camera-facing
+    // face whose plane it crosses last, and misses if it leaves another slab first.
+    vec3 ray = u_pixelRay * vec3(gl_FragCoord.xy, 1.0);
+    vec3 inverseRay = 1.0 / ray;
+    vec3 enter = (center + 1.5 * side) * inverseRay;
+    vec3 leave = (center - 1.5 * side) * inverseRay;
+    float t = max(max(enter.x, enter.y), enter.z);
+    if (t > min(min(leave.x, leave.y), leave.z)) discard;
+
+    // Position on the cube in the units of scene.vert's mesh, -1.5 to 1.5 per axis,
+    // and the sticker's row and column as scene.vert works them out.
+    vec3 pos = t * ray - center;
+    vec3 p = pos + 1.5, q = 1.5 - pos;
+    vec2 sticker;
+    uint word;
+    if (t == enter.x) {
+        sticker = side.x > 0.0 ? vec2(q.y, q.z) : vec2(q.y, p.z);
+        word = stickers.x;
+    } else if (t == enter.y) {
+        sticker = side.y > 0.0 ? vec2(p.z, p.x) : vec2(q.z, p.x);
+        word = stickers.y;
+    } else {
+        sticker = side.z > 0.0 ? vec2(q.y, p.x) : vec2(q.y, q.x);
+        word = stickers.z;
+    }
+
+    ivec2 rc = clamp(ivec2(sticker), 0, 2);
+    uint colour = (word >> uint(3 * (rc.x * 3 + rc.y))) & 7u;
+    FragColor = vec4(vec3((FACE_COLORS >> (colour * 2u)) & 3u) * 0.5, 1.0);
+}
@@ -0,0 +1,37 @@
+#version 330 core
+layout (location = 1) in vec3 aOffset;   // center of the cube in the scene
+layout (location = 2) in uint aCube;     // index into the facelet buffer
+
+flat out vec3 center;    // Of the cube, relative to the camera
+flat out vec3 side;      // Which way each axis faces the camera, +1 or -1
+flat out uvec3 stickers; // Sticker words of the x, y and z faces drawn
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 cameraPos;
+uniform vec4 u_viewport;           // x, y, width, height
+uniform usamplerBuffer u_facelets; // per cube, one word per face in URFDLB order
+
+const float HALF_SIZE = 1.5; // CubeScene::CUBE_SIZE / 2
+
+void main()
+{
+    center = aOffset - cameraPos;
+    side = step(aOffset, cameraPos) * 2.0 - 1.0;
+    stickers = uvec3(texelFetch(u_facelets, int(aCube) * 6 + (side.x > 0.0 ? 1 : 4)).r,  // R or L
+                     texelFetch(u_facelets, int(aCube) * 6 + (side.y > 0.0 ? 0 : 3)).r,  // U or D
+                     texelFetch(u_facelets, int(aCube) * 6 + (side.z > 0.0 ? 2 : 5)).r); // F or B
+
+    // One point covering the window bounds of all eight corners.
+    mat4 viewProjection = projection * view;
+    vec2 low = vec2(1e30), high = vec2(-1e30);
+    for (int i = 0; i < 8; ++i) {
+        vec3 corner = HALF_SIZE * vec3(i & 1, (i >> 1) & 1, i >> 2) * 2.0 - HALF_SIZE;
+        vec4 clip = viewProjection * vec4(aOffset + corner, 1.0);
+        low = min(low, clip.xy / clip.w);
+        high = max(high, clip.xy / clip.w);
+    }
+    vec4 clipCenter = viewProjection * vec4(aOffset, 1.0);
+    gl_Position = vec4((low + high) * 0.5 * clipCenter.w, clipCenter.zw);
+    gl_PointSize = max(high.x - low.x, high.y - low.y) * 0.5 * max(u_viewport.z, u_viewport.w) + 1.0;
+}
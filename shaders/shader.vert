@@ -1,6 +1,7 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;   // the position variable has attribute position 0
 layout (location = 1) in vec3 aColor; // the color variable has attribute position 1
+layout (location = 2) in mat4 aInstanceModel; // per-piece transform, locations 2 to 5
 
 out vec3 pointColor; // output a color to the fragment shader
 
@@ -10,6 +11,6 @@ uniform mat4 projection;
   
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * model * aInstanceModel * vec4(aPos, 1.0);
     pointColor = aColor; // pass the color to the fragment shader
 }
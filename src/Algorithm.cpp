@@ -0,0 +1,89 @@
+#include "Algorithm.h"
+
+namespace {
+
+int moveAxis(int move) {
+    return moveFace(move) % 3; // U/D, R/L and F/B
+}
+
+} // namespace
+
+Algorithm::Algorithm() {
+}
+
+Algorithm::Algorithm(const std::vector<int>& moves) {
+    for (int move : moves) append(move);
+}
+
+bool Algorithm::parse(const std::string& notation, Algorithm& algorithm) {
+    static const std::string faces = "URFDLB";
+    Algorithm result;
+    size_t i = 0;
+    while (i < notation.size()) {
+        char c = notation[i++];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') continue;
+        size_t face = faces.find(c);
+        if (face == std::string::npos) return false;
+        int power = 1;
+        if (i < notation.size() && notation[i] == '2') {
+            power = 2;
+            ++i;
+            if (i < notation.size() && notation[i] == '\'') ++i; // R2' is R2
+        } else if (i < notation.size() && notation[i] == '\'') {
+            power = 3;
+            ++i;
+        }
+        result.append(makeMove((int)face, power));
+    }
+    algorithm = result;
+    return true;
+}
+
+std::string Algorithm::toString() const {
+    std::string text;
+    for (int move : sequence) {
+        if (!text.empty()) text += ' ';
+        text += moveName(move);
+    }
+    return text;
+}
+
+Algorithm Algorithm::inverse() const {
+    Algorithm result;
+    for (auto it = sequence.rbegin(); it != sequence.rend(); ++it) result.sequence.push_back(inverseMove(*it));
+    result.permutation = permutation.inverse();
+    return result;
+}
+
+Algorithm& Algorithm::append(int move) {
+    permutation.apply(move);
+
+    // Look through the run of same-axis moves at the end for one on the same face. At
+    // most two moves are in the run, one per face, since the faces commute.
+    int axis = moveAxis(move);
+    for (int k = (int)sequence.size() - 1; k >= 0 && k >= (int)sequence.size() - 2; --k) {
+        if (moveAxis(sequence[k]) != axis) break;
+        if (moveFace(sequence[k]) != moveFace(move)) continue;
+        int power = (movePower(sequence[k]) + movePower(move)) % 4;
+        if (power == 0) sequence.erase(sequence.begin() + k);
+        else sequence[k] = makeMove(moveFace(move), power);
+        return *this;
+    }
+    sequence.push_back(move);
+    return *this;
+}
+
+Algorithm& Algorithm::append(const Algorithm& other) {
+    for (int move : other.sequence) append(move);
+    return *this;
+}
+
+CubeState Algorithm::appliedTo(const CubeState& state) const {
+    CubeState result = state;
+    result.multiply(permutation);
+    return result;
+}
+
+void applyAlgorithm(PackedCube* cubes, int count, const Algorithm& algorithm) {
+    applyPermutation(cubes, count, algorithm.effect());
+}
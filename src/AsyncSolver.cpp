@@ -0,0 +1,125 @@
+#include "AsyncSolver.h"
+#include "OptimalSolver.h"
+#include "ThistlethwaiteSolver.h"
+#include "TwoPhaseSolver.h"
+#include <chrono>
+
+AsyncSolver::AsyncSolver()
+    : stopping(false), currentId(0), cancelSearch(false), working(false), ready(nullptr) {
+    worker = std::thread(&AsyncSolver::run, this);
+}
+
+AsyncSolver::~AsyncSolver() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        next.reset();
+        cancelSearch = true;
+    }
+    wake.notify_one();
+    worker.join();
+    delete ready.exchange(nullptr);
+}
+
+uint64_t AsyncSolver::request(const CubeState& cube, Method method, Callback callback, double budgetMs) {
+    std::unique_ptr<Request> r(new Request);
+    r->cube = cube;
+    r->method = method;
+    r->budgetMs = budgetMs;
+    r->callback = std::move(callback);
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = r->id = ++currentId;
+        next = std::move(r);
+        working = true;
+        cancelSearch = true; // Whatever is running is out of date now
+    }
+    wake.notify_one();
+    return id;
+}
+
+void AsyncSolver::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    next.reset();
+    ++currentId;
+    cancelSearch = true;
+}
+
+bool AsyncSolver::busy() const {
+    return working.load(std::memory_order_relaxed);
+}
+
+bool AsyncSolver::poll() {
+    std::unique_ptr<Delivery> delivery(ready.exchange(nullptr, std::memory_order_acquire));
+    if (!delivery || delivery->result.id != currentId.load(std::memory_order_relaxed)) return false;
+    if (delivery->callback) delivery->callback(delivery->result);
+    return true;
+}
+
+void AsyncSolver::run() {
+    for (;;) {
+        std::unique_ptr<Request> r;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || next; });
+            if (stopping) return;
+            r = std::move(next);
+            cancelSearch = false;
+        }
+        solve(*r);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!next) working = false;
+    }
+}
+
+void AsyncSolver::solve(const Request& request) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Result result;
+    result.id = request.id;
+    result.cube = request.cube;
+    result.solved = false;
+    result.final = false;
+    result.milliseconds = 0;
+    auto elapsed = [start] {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    if (request.method == THISTLETHWAITE) {
+        if (!thistlethwaite) thistlethwaite.reset(new ThistlethwaiteSolver);
+        result.solved = thistlethwaite->solve(request.cube, result.solution);
+    } else if (optimalCache.lookup(request.cube, result.solution)
+        || (request.method == TWO_PHASE && twoPhaseCache.lookup(request.cube, result.solution))) {
+        result.solved = true;
+    } else if (request.method == OPTIMAL) {
+        if (!optimal) optimal.reset(new OptimalSolver(0));
+        result.solved = optimal->solve(request.cube, result.solution, &cancelSearch);
+    } else {
+        if (!twoPhase) twoPhase.reset(new TwoPhaseSolver);
+        TwoPhaseSolver::Budget budget = TwoPhaseSolver::Budget::milliseconds(request.budgetMs);
+        budget.cancel = &cancelSearch;
+        result.solved = twoPhase->solveAnytime(request.cube, result.solution, budget,
+            [&](const std::vector<int>& shorter) {
+                Result improvement = result;
+                improvement.solution = shorter;
+                improvement.solved = true;
+                improvement.milliseconds = elapsed();
+                publish(request, improvement);
+            });
+    }
+    // A cancelled search has nothing worth reporting, and its callback would be dropped anyway.
+    if (cancelSearch.load(std::memory_order_relaxed)) return;
+    if (result.solved && request.method != THISTLETHWAITE)
+        (request.method == OPTIMAL ? optimalCache : twoPhaseCache).store(request.cube, result.solution);
+    result.final = true;
+    result.milliseconds = elapsed();
+    publish(request, result);
+}
+
+void AsyncSolver::publish(const Request& request, Result& result) {
+    Delivery* delivery = new Delivery;
+    delivery->result = std::move(result);
+    delivery->callback = request.callback;
+    // Replaces an improvement the caller has not collected yet: only the newest matters.
+    delete ready.exchange(delivery, std::memory_order_acq_rel);
+}
@@ -0,0 +1,7 @@
+#include "Coordinates.h"
+
+// constinit: an error rather than a silent fallback to dynamic initialization if any
+// of these ever stops being a constant expression.
+constinit const MoveTable<uint16_t, N_TWIST> twistMoveTable = makeOrientationMoveTable<N_TWIST, 8, 3>(true);
+constinit const MoveTable<uint16_t, N_FLIP> flipMoveTable = makeOrientationMoveTable<N_FLIP, 12, 2>(false);
+constinit const MoveTable<uint16_t, N_SLICE> sliceMoveTable = makeSliceMoveTable();
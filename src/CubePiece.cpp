@@ -1,4 +1,6 @@
 #include "CubePiece.h"
+#include "RenderCounters.h"
+#include "CubieGeometry.h"
 #include <vector>
 #include <glm/glm.hpp>
 
@@ -75,8 +77,7 @@ GLuint CubePiece::s_EBO_faces = 0;
 GLuint CubePiece::s_EBO_edges = 0;
 bool CubePiece::s_resourcesInitialized = false;
 
-// CubePiece::CubePiece() : rotation(glm::vec3(0.0f)){
-CubePiece::CubePiece() : orientation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f)) { // Initialize with identity quaternion
+CubePiece::CubePiece() : orientation(0) { // Identity rotation
 
 };
 
@@ -106,13 +107,43 @@ void CubePiece::initSharedResources() {
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_EBO_edges);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(edgeIndices), edgeIndices, GL_STATIC_DRAW);
 
+    bindMeshAttributes();
+
+    glBindVertexArray(0);
+    s_resourcesInitialized = true;
+}
+
+void CubePiece::bindMeshAttributes() {
+    glBindBuffer(GL_ARRAY_BUFFER, s_VBO);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
+}
 
-    glBindVertexArray(0);
-    s_resourcesInitialized = true;
+void CubePiece::bindInstanceAttributes(GLuint instanceVBO, GLsizei stride) {
+    // A mat4 attribute takes four consecutive locations, one per column.
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    for (GLuint column = 0; column < 4; ++column) {
+        GLuint location = INSTANCE_MODEL_LOCATION + column;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (void*)(column * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+}
+
+void CubePiece::drawInstanced(GLsizei count) {
+    if (!s_resourcesInitialized) return;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_EBO_faces);
+    glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, count);
+    ++RenderCounters::drawCalls;
+}
+
+void CubePiece::drawEdgesInstanced(GLsizei count) {
+    if (!s_resourcesInitialized) return;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_EBO_edges);
+    glDrawElementsInstanced(GL_LINES, 24, GL_UNSIGNED_INT, 0, count);
+    ++RenderCounters::drawCalls;
 }
 
 void CubePiece::cleanupSharedResources() {
@@ -131,35 +162,23 @@ void CubePiece::setupMesh(){
     // The individual VAO, VBO members are no longer used for drawing.
 }
 
-void CubePiece::draw(Shader& shader){
-    if (!s_resourcesInitialized) return;
-    shader.use();
-    glBindVertexArray(s_VAO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_EBO_faces); // Bind EBO for faces
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+const glm::mat4& CubePiece::rotationMatrix(int rotation) {
+    static const std::vector<glm::mat4> matrices = [] {
+        std::vector<glm::mat4> m(N_ROTATIONS, glm::mat4(1.0f));
+        for (int r = 0; r < N_ROTATIONS; ++r)
+            for (int row = 0; row < 3; ++row)
+                for (int col = 0; col < 3; ++col)
+                    m[r][col][row] = (float)cubeRotation(r).m[row * 3 + col]; // glm is column-major
+        return m;
+    }();
+    return matrices[rotation];
 }
 
-void CubePiece::drawEdges(Shader& shader){
-    if (!s_resourcesInitialized) return;
-    shader.use();
-    glBindVertexArray(s_VAO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_EBO_edges); // Bind EBO for edges
-    glDrawElements(GL_LINES, 24, GL_UNSIGNED_INT, 0); // 12 edges * 2 vertices per edge = 24 indices
-    glBindVertexArray(0);
-}
-
-
-glm::mat4 CubePiece::get_model(){
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::mat4_cast(orientation) * model; // Apply orientation
-    return model;
+const glm::mat4& CubePiece::get_model() const {
+    return rotationMatrix(orientation);
 }
 
-// void CubePiece::update_rotation(glm::vec3 new_angle){
-void CubePiece::update_orientation(glm::quat rotation_quat){
-    // Multiply by the rotation quaternion to combine rotations.
+void CubePiece::update_orientation(int rotation){
     // The order matters: new_orientation = rotation_to_apply * current_orientation
-    orientation = rotation_quat * orientation;
-    orientation = glm::normalize(orientation); // Keep the quaternion normalized
+    orientation = composeRotations(rotation, orientation);
 }
\ No newline at end of file
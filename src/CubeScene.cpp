@@ -0,0 +1,346 @@
+#include "CubeScene.h"
+#include "RenderCounters.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace {
+
+const int FACELETS = 54;
+const char* FACE_NAMES = "URFDLB";
+
+// The three faces towards +x, +y and +z: outward normal and two in-plane axes with
+// u x v = normal. The vertex shader mirrors each axis to face the camera, so these
+// are the only faces ever drawn.
+const float faceAxes[3][3][3] = {
+    {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+    {{0, 1, 0}, {0, 0, 1}, {1, 0, 0}},
+    {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}},
+};
+
+const int FACE_VERTICES = 18;     // Two triangles on each of three faces
+const int EDGE_VERTICES = 3 * 16; // Four lines each way across each face
+
+// Vertices are x, y, z in cube units and the axis of their face, -1 for edge lines.
+std::vector<float> buildMesh() {
+    std::vector<float> mesh;
+    auto push = [&](const float* n, const float* u, const float* v, float a, float b, float scale, float axis) {
+        for (int i = 0; i < 3; ++i) mesh.push_back((n[i] + a * u[i] + b * v[i]) * scale * CubeScene::CUBE_SIZE / 2);
+        mesh.push_back(axis);
+    };
+    const float corners[6][2] = {{-1, -1}, {1, -1}, {1, 1}, {1, 1}, {-1, 1}, {-1, -1}};
+    for (int f = 0; f < 3; ++f)
+        for (const auto& c : corners) push(faceAxes[f][0], faceAxes[f][1], faceAxes[f][2], c[0], c[1], 1.0f, (float)f);
+
+    // Lifted slightly off the faces so they win the depth test.
+    const float lift = 1.004f;
+    for (int f = 0; f < 3; ++f) {
+        const float* n = faceAxes[f][0];
+        const float* u = faceAxes[f][1];
+        const float* v = faceAxes[f][2];
+        for (int line = 0; line < 4; ++line) {
+            float t = -1.0f + line * 2.0f / 3.0f;
+            push(n, u, v, t, -1, lift, -1);
+            push(n, u, v, t, 1, lift, -1);
+            push(n, u, v, -1, t, lift, -1);
+            push(n, u, v, 1, t, lift, -1);
+        }
+    }
+    return mesh;
+}
+
+// For a perspective projection, the world direction (up to a positive factor) of the
+// view ray through window position (x, y): the inverse of the map from directions to
+// homogeneous window coordinates, which the camera position drops out of.
+glm::mat3 pixelRay(const glm::mat4& viewProjection, const GLint viewport[4]) {
+    glm::mat3 clip; // Rows x, y and w of viewProjection, xyz columns
+    for (int c = 0; c < 3; ++c)
+        clip[c] = glm::vec3(viewProjection[c][0], viewProjection[c][1], viewProjection[c][3]);
+    glm::mat3 window(1.0f);
+    window[0][0] = viewport[2] * 0.5f;
+    window[1][1] = viewport[3] * 0.5f;
+    window[2] = glm::vec3(viewport[0] + viewport[2] * 0.5f, viewport[1] + viewport[3] * 0.5f, 1.0f);
+    return glm::inverse(window * clip);
+}
+
+} // namespace
+
+CubeScene::CubeScene() {
+    edgeInstances = 0;
+    meshInstances = 0;
+    edgeDistance = 40.0f;
+    spriteDistance = 60.0f;
+    VAO = 0;
+    spriteVAO = 0;
+    meshVBO = 0;
+    instanceVBO = 0;
+    faceletBuffer = 0;
+    faceletTexture = 0;
+    instanceCapacity = 0;
+    dirtyBegin = 0;
+    dirtyEnd = 0;
+    faceletsReallocate = true;
+    uniforms.program = 0;
+    spriteUniforms.program = 0;
+}
+
+CubeScene::~CubeScene() {
+}
+
+void CubeScene::setupMesh() {
+    std::vector<float> mesh = buildMesh();
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &meshVBO);
+    glGenBuffers(1, &instanceVBO);
+    glGenBuffers(1, &faceletBuffer);
+    glGenTextures(1, &faceletTexture);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+    glBufferData(GL_ARRAY_BUFFER, mesh.size() * sizeof(float), mesh.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, x));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(Instance), (void*)offsetof(Instance, cube));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+
+    // Sprites read the same instance buffer, one point per entry.
+    glGenVertexArrays(1, &spriteVAO);
+    glBindVertexArray(spriteVAO);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, x));
+    glEnableVertexAttribArray(1);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(Instance), (void*)offsetof(Instance, cube));
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+
+    instanceCapacity = 0;
+    faceletsReallocate = true;
+}
+
+void CubeScene::cleanupMesh() {
+    if (VAO == 0) return;
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteVertexArrays(1, &spriteVAO);
+    glDeleteBuffers(1, &meshVBO);
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteBuffers(1, &faceletBuffer);
+    glDeleteTextures(1, &faceletTexture);
+    VAO = 0; spriteVAO = 0; meshVBO = 0; instanceVBO = 0; faceletBuffer = 0; faceletTexture = 0;
+}
+
+void CubeScene::setStates(const std::vector<CubeState>& cubes) {
+    states = cubes;
+    int columns = (int)std::ceil(std::sqrt((double)states.size()));
+    int rows = columns == 0 ? 0 : ((int)states.size() + columns - 1) / columns;
+    positions.resize(states.size());
+    for (size_t i = 0; i < states.size(); ++i) {
+        int column = (int)i % columns, row = (int)i / columns;
+        positions[i] = glm::vec3((column - (columns - 1) / 2.0f) * SPACING, 0.0f, (row - (rows - 1) / 2.0f) * SPACING);
+    }
+    faceletsReallocate = true;
+}
+
+void CubeScene::setState(int index, const CubeState& cube) {
+    if (states[index] == cube) return;
+    states[index] = cube;
+    if (dirtyBegin == dirtyEnd) {
+        dirtyBegin = index;
+        dirtyEnd = index + 1;
+    } else {
+        dirtyBegin = std::min(dirtyBegin, (size_t)index);
+        dirtyEnd = std::max(dirtyEnd, (size_t)index + 1);
+    }
+}
+
+int CubeScene::size() const {
+    return (int)states.size();
+}
+
+glm::vec3 CubeScene::center() const {
+    return glm::vec3(0.0f); // The grid is laid out around the origin
+}
+
+float CubeScene::radius() const {
+    float r = 0.0f;
+    for (const glm::vec3& p : positions) r = std::fmax(r, glm::length(p));
+    return r + CUBE_SIZE;
+}
+
+void CubeScene::setEdgeDistance(float distance) {
+    edgeDistance = distance;
+}
+
+void CubeScene::setSpriteDistance(float distance) {
+    spriteDistance = distance;
+}
+
+void CubeScene::uploadFacelets() {
+    size_t begin = faceletsReallocate ? 0 : dirtyBegin;
+    size_t end = faceletsReallocate ? states.size() : dirtyEnd;
+    // One word per face: sticker k's colour (0..5 for U..B) in bits 3k to 3k + 2.
+    std::vector<uint32_t> faces((end - begin) * 6);
+    for (size_t i = begin; i < end; ++i) {
+        std::string f = toFacelets(states[i]);
+        for (int k = 0; k < FACELETS; ++k)
+            faces[(i - begin) * 6 + k / 9] |= (uint32_t)(std::strchr(FACE_NAMES, f[k]) - FACE_NAMES) << (3 * (k % 9));
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, faceletBuffer);
+    if (faceletsReallocate) {
+        glBufferData(GL_TEXTURE_BUFFER, faces.size() * sizeof(uint32_t), faces.data(), GL_STATIC_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, faceletTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, faceletBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    } else {
+        glBufferSubData(GL_TEXTURE_BUFFER, begin * 6 * sizeof(uint32_t), faces.size() * sizeof(uint32_t), faces.data());
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    faceletsReallocate = false;
+    dirtyBegin = dirtyEnd = 0;
+}
+
+void CubeScene::Uniforms::lookUp(Shader& shader) {
+    program = shader.ID;
+    projection = shader.lookUpLocation("projection");
+    view = shader.lookUpLocation("view");
+    cameraPos = shader.lookUpLocation("cameraPos");
+    facelets = shader.lookUpLocation("u_facelets");
+    isEdge = shader.lookUpLocation("u_isEdge");
+    edgeColor = shader.lookUpLocation("u_edgeColor");
+    viewport = shader.lookUpLocation("u_viewport");
+    pixelRay = shader.lookUpLocation("u_pixelRay");
+}
+
+void CubeScene::cull(const glm::mat4& viewProjection, const glm::vec3& cameraPos) {
+    // Frustum planes (a, b, c, d) from the rows of the matrix, pointing inwards.
+    glm::vec4 planes[6];
+    for (int i = 0; i < 3; ++i) {
+        glm::vec4 row(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        glm::vec4 w(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+        planes[2 * i] = w + row;
+        planes[2 * i + 1] = w - row;
+    }
+    float planeScale[6];
+    for (int p = 0; p < 6; ++p)
+        planeScale[p] = glm::length(glm::vec3(planes[p].x, planes[p].y, planes[p].z));
+
+    // Bounding sphere of a cube, including the lifted edge lines.
+    const float boundingRadius = CUBE_SIZE * 0.5f * std::sqrt(3.0f) * 1.01f;
+    const float edgeDistance2 = edgeDistance * edgeDistance;
+
+    const float spriteDistance2 = spriteDistance * spriteDistance;
+
+    // Cubes with edges fill the front of the list and sprites the back, with the other
+    // meshes put in between afterwards: the mesh pass draws a prefix of the instance
+    // buffer, the edge pass a shorter one, and the sprite pass the rest.
+    visible.resize(states.size());
+    meshesOnly.clear();
+    size_t front = 0, back = states.size();
+    for (size_t i = 0; i < states.size(); ++i) {
+        const glm::vec3& p = positions[i];
+        bool inside = true;
+        for (int k = 0; k < 6 && inside; ++k)
+            inside = planes[k].x * p.x + planes[k].y * p.y + planes[k].z * p.z + planes[k].w >= -boundingRadius * planeScale[k];
+        if (!inside) continue;
+        glm::vec3 d = p - cameraPos;
+        float distance2 = glm::dot(d, d);
+        Instance instance = {p.x, p.y, p.z, (uint32_t)i};
+        if (distance2 >= spriteDistance2) visible[--back] = instance;
+        else if (distance2 < edgeDistance2) visible[front++] = instance;
+        else meshesOnly.push_back(instance);
+    }
+    // Close the gap between the groups.
+    size_t sprites = states.size() - back;
+    std::memmove(visible.data() + front + meshesOnly.size(), visible.data() + back, sprites * sizeof(Instance));
+    std::copy(meshesOnly.begin(), meshesOnly.end(), visible.begin() + front);
+    edgeInstances = (int)front;
+    meshInstances = (int)(front + meshesOnly.size());
+    visible.resize(meshInstances + sprites);
+}
+
+void CubeScene::draw(Shader& shader, Shader& spriteShader, const glm::mat4& projection, const glm::mat4& view,
+                     const glm::vec3& cameraPos) {
+    if (VAO == 0) return;
+    if (faceletsReallocate || dirtyBegin != dirtyEnd) uploadFacelets();
+
+    cull(projection * view, cameraPos);
+    if (visible.empty()) return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    if (visible.size() > instanceCapacity) {
+        instanceCapacity = visible.size();
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, visible.size() * sizeof(Instance), visible.data());
+
+    if (uniforms.program != shader.ID) uniforms.lookUp(shader);
+    if (spriteUniforms.program != spriteShader.ID) spriteUniforms.lookUp(spriteShader);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, faceletTexture);
+
+    // Mirroring flips the winding of some faces; all drawn faces point at the camera anyway.
+    GLboolean culling = glIsEnabled(GL_CULL_FACE);
+    glDisable(GL_CULL_FACE);
+
+    if (meshInstances > 0) {
+        shader.use();
+        shader.setMat4(uniforms.projection, projection);
+        shader.setMat4(uniforms.view, view);
+        shader.setVec3(uniforms.cameraPos, cameraPos);
+        shader.setInt(uniforms.facelets, 0);
+        glBindVertexArray(VAO);
+
+        shader.setBool(uniforms.isEdge, false);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, FACE_VERTICES, meshInstances);
+        ++RenderCounters::drawCalls;
+
+        if (edgeInstances > 0) {
+            shader.setBool(uniforms.isEdge, true);
+            shader.setVec4(uniforms.edgeColor, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+            glDrawArraysInstanced(GL_LINES, FACE_VERTICES, EDGE_VERTICES, edgeInstances);
+            ++RenderCounters::drawCalls;
+        }
+    }
+
+    if (visible.size() > (size_t)meshInstances) {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        spriteShader.use();
+        spriteShader.setMat4(spriteUniforms.projection, projection);
+        spriteShader.setMat4(spriteUniforms.view, view);
+        spriteShader.setVec3(spriteUniforms.cameraPos, cameraPos);
+        spriteShader.setInt(spriteUniforms.facelets, 0);
+        spriteShader.setVec4(spriteUniforms.viewport,
+                             glm::vec4(viewport[0], viewport[1], viewport[2], viewport[3]));
+        spriteShader.setMat3(spriteUniforms.pixelRay, pixelRay(projection * view, viewport));
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        glBindVertexArray(spriteVAO);
+        glDrawArrays(GL_POINTS, meshInstances, (GLsizei)visible.size() - meshInstances);
+        ++RenderCounters::drawCalls;
+        glDisable(GL_PROGRAM_POINT_SIZE);
+    }
+
+    if (culling) glEnable(GL_CULL_FACE);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+int CubeScene::visibleCount() const {
+    return (int)visible.size();
+}
+
+int CubeScene::edgeCount() const {
+    return edgeInstances;
+}
+
+int CubeScene::spriteCount() const {
+    return (int)visible.size() - meshInstances;
+}
@@ -0,0 +1,163 @@
+#include "CubeState.h"
+#include <cstring>
+
+namespace {
+
+int permutationParity(const uint8_t* slots, int n) {
+    int parity = 0;
+    for (int i = 0; i < n; ++i)
+        for (int j = i + 1; j < n; ++j)
+            if ((slots[i] & 0x0F) > (slots[j] & 0x0F)) parity ^= 1;
+    return parity;
+}
+
+} // namespace
+
+std::string moveName(int move) {
+    static const char faces[] = "URFDLB";
+    static const char* suffixes[] = {"", "2", "'"};
+    return std::string(1, faces[moveFace(move)]) + suffixes[move % 3];
+}
+
+int parseMove(const std::string& name) {
+    static const std::string faces = "URFDLB";
+    if (name.empty() || name.size() > 2) return -1;
+    size_t face = faces.find(name[0]);
+    if (face == std::string::npos) return -1;
+    if (name.size() == 1) return makeMove((int)face, 1);
+    if (name[1] == '2') return makeMove((int)face, 2);
+    if (name[1] == '\'') return makeMove((int)face, 3);
+    return -1;
+}
+
+void CubeState::multiply(const CubeState& other) {
+    uint8_t c[8], e[12];
+    for (int i = 0; i < 8; ++i) {
+        uint8_t v = corners[other.cornerPiece(i)] + (other.corners[i] & 0xF0);
+        c[i] = v >= 0x30 ? v - 0x30 : v;
+    }
+    for (int i = 0; i < 12; ++i) e[i] = edges[other.edgePiece(i)] ^ (other.edges[i] & 0xF0);
+    std::memcpy(corners, c, sizeof(c));
+    std::memcpy(edges, e, sizeof(e));
+}
+
+CubeState CubeState::inverse() const {
+    CubeState result;
+    for (int i = 0; i < 8; ++i)
+        result.corners[cornerPiece(i)] = (uint8_t)(((3 - cornerOrientation(i)) % 3) << 4 | i);
+    for (int i = 0; i < 12; ++i)
+        result.edges[edgePiece(i)] = (uint8_t)(edgeOrientation(i) << 4 | i);
+    return result;
+}
+
+int CubeState::cornerParity() const {
+    return permutationParity(corners, 8);
+}
+
+int CubeState::edgeParity() const {
+    return permutationParity(edges, 12);
+}
+
+bool CubeState::isSolved() const {
+    return *this == CubeState();
+}
+
+bool CubeState::isValid() const {
+    int seenCorners = 0, seenEdges = 0, twist = 0, flip = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (cornerPiece(i) >= 8 || cornerOrientation(i) >= 3) return false;
+        seenCorners |= 1 << cornerPiece(i);
+        twist += cornerOrientation(i);
+    }
+    for (int i = 0; i < 12; ++i) {
+        if (edgePiece(i) >= 12 || edgeOrientation(i) >= 2) return false;
+        seenEdges |= 1 << edgePiece(i);
+        flip += edgeOrientation(i);
+    }
+    return seenCorners == 0xFF && seenEdges == 0xFFF && twist % 3 == 0 && flip % 2 == 0
+        && cornerParity() == edgeParity();
+}
+
+bool CubeState::operator==(const CubeState& other) const {
+    return std::memcmp(corners, other.corners, sizeof(corners)) == 0
+        && std::memcmp(edges, other.edges, sizeof(edges)) == 0;
+}
+
+namespace {
+
+// Sticker indices of each corner and edge slot, starting with its U or D sticker (or
+// F or B for the slice edges), and the faces of each piece in the same order.
+const int cornerFacelet[8][3] = {
+    {8, 9, 20}, {6, 18, 38}, {0, 36, 47}, {2, 45, 11},
+    {29, 26, 15}, {27, 44, 24}, {33, 53, 42}, {35, 17, 51}
+};
+const int edgeFacelet[12][2] = {
+    {5, 10}, {7, 19}, {3, 37}, {1, 46}, {32, 16}, {28, 25},
+    {30, 43}, {34, 52}, {23, 12}, {21, 41}, {50, 39}, {48, 14}
+};
+const int cornerFace[8][3] = {
+    {FACE_U, FACE_R, FACE_F}, {FACE_U, FACE_F, FACE_L}, {FACE_U, FACE_L, FACE_B}, {FACE_U, FACE_B, FACE_R},
+    {FACE_D, FACE_F, FACE_R}, {FACE_D, FACE_L, FACE_F}, {FACE_D, FACE_B, FACE_L}, {FACE_D, FACE_R, FACE_B}
+};
+const int edgeFace[12][2] = {
+    {FACE_U, FACE_R}, {FACE_U, FACE_F}, {FACE_U, FACE_L}, {FACE_U, FACE_B},
+    {FACE_D, FACE_R}, {FACE_D, FACE_F}, {FACE_D, FACE_L}, {FACE_D, FACE_B},
+    {FACE_F, FACE_R}, {FACE_F, FACE_L}, {FACE_B, FACE_L}, {FACE_B, FACE_R}
+};
+
+} // namespace
+
+bool parseFacelets(const std::string& facelets, CubeState& cube) {
+    if (facelets.size() != 54) return false;
+    int faceOf[256];
+    for (int& f : faceOf) f = -1;
+    for (int f = 0; f < 6; ++f) {
+        unsigned char center = (unsigned char)facelets[f * 9 + 4];
+        if (faceOf[center] != -1) return false;
+        faceOf[center] = f;
+    }
+    int face[54];
+    for (int i = 0; i < 54; ++i) {
+        face[i] = faceOf[(unsigned char)facelets[i]];
+        if (face[i] < 0) return false;
+    }
+
+    CubeState result;
+    for (int i = 0; i < 8; ++i) {
+        int ori = 0;
+        while (ori < 3 && face[cornerFacelet[i][ori]] != FACE_U && face[cornerFacelet[i][ori]] != FACE_D) ++ori;
+        if (ori == 3) return false;
+        int first = face[cornerFacelet[i][(ori + 1) % 3]], second = face[cornerFacelet[i][(ori + 2) % 3]];
+        int piece = 0;
+        while (piece < 8 && (cornerFace[piece][0] != face[cornerFacelet[i][ori]]
+                             || cornerFace[piece][1] != first || cornerFace[piece][2] != second)) ++piece;
+        if (piece == 8) return false;
+        result.corners[i] = (uint8_t)(ori << 4 | piece);
+    }
+    for (int i = 0; i < 12; ++i) {
+        int a = face[edgeFacelet[i][0]], b = face[edgeFacelet[i][1]];
+        int piece = 0, flip = 0;
+        for (; piece < 12; ++piece) {
+            if (edgeFace[piece][0] == a && edgeFace[piece][1] == b) break;
+            if (edgeFace[piece][0] == b && edgeFace[piece][1] == a) { flip = 1; break; }
+        }
+        if (piece == 12) return false;
+        result.edges[i] = (uint8_t)(flip << 4 | piece);
+    }
+    if (!result.isValid()) return false;
+    cube = result;
+    return true;
+}
+
+std::string toFacelets(const CubeState& cube) {
+    static const char faces[] = "URFDLB";
+    std::string facelets(54, ' ');
+    for (int f = 0; f < 6; ++f) facelets[f * 9 + 4] = faces[f];
+    for (int i = 0; i < 8; ++i)
+        for (int n = 0; n < 3; ++n)
+            facelets[cornerFacelet[i][(n + cube.cornerOrientation(i)) % 3]] = faces[cornerFace[cube.cornerPiece(i)][n]];
+    for (int i = 0; i < 12; ++i)
+        for (int n = 0; n < 2; ++n)
+            facelets[edgeFacelet[i][(n + cube.edgeOrientation(i)) % 2]] = faces[edgeFace[cube.edgePiece(i)][n]];
+    return facelets;
+}
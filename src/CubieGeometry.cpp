@@ -0,0 +1,173 @@
+#include "CubieGeometry.h"
+
+namespace {
+
+constexpr int cornerPositions[8][3] = {
+    {1, 1, 1}, {-1, 1, 1}, {-1, 1, -1}, {1, 1, -1},
+    {1, -1, 1}, {-1, -1, 1}, {-1, -1, -1}, {1, -1, -1}
+};
+
+constexpr int edgePositions[12][3] = {
+    {1, 1, 0}, {0, 1, 1}, {-1, 1, 0}, {0, 1, -1},
+    {1, -1, 0}, {0, -1, 1}, {-1, -1, 0}, {0, -1, -1},
+    {1, 0, 1}, {-1, 0, 1}, {-1, 0, -1}, {1, 0, -1}
+};
+
+// Outward axis of each face in U R F D L B order: axis index and sign.
+constexpr int faceAxis[6] = {1, 0, 2, 1, 0, 2};
+constexpr int faceSign[6] = {1, 1, 1, -1, -1, -1};
+
+// Everything the functions below look up, computed at compile time from CubeState's
+// constexpr moves: no first-use initialization, and no ordering problem with another
+// translation unit's tables.
+struct Geometry
+{
+    CubeRotation rotations[N_ROTATIONS];
+    int composition[N_ROTATIONS][N_ROTATIONS];
+    int faceTurnRotation[6];          // Clockwise quarter turn of each face
+    int cornerRotation[8][8][3];      // [slot][piece][orientation]
+    int edgeRotation[12][12][2];
+    int gridCells[27][2];             // [cell] -> {0 none, 1 corner, 2 edge; slot}
+};
+
+constexpr CubeRotation multiply(const CubeRotation& a, const CubeRotation& b) {
+    CubeRotation r = {};
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            r.m[i * 3 + j] = a.m[i * 3] * b.m[j] + a.m[i * 3 + 1] * b.m[3 + j] + a.m[i * 3 + 2] * b.m[6 + j];
+    return r;
+}
+
+constexpr int findRotation(const Geometry& g, const CubeRotation& r) {
+    for (int i = 0; i < N_ROTATIONS; ++i) {
+        bool same = true;
+        for (int k = 0; k < 9 && same; ++k) same = g.rotations[i].m[k] == r.m[k];
+        if (same) return i;
+    }
+    return -1;
+}
+
+// Quarter turn by +90 degrees (counterclockwise seen from the positive end) around an axis.
+constexpr CubeRotation axisQuarterTurn(int axis) {
+    CubeRotation r = {{0, 0, 0, 0, 0, 0, 0, 0, 0}};
+    int a = (axis + 1) % 3, b = (axis + 2) % 3;
+    r.m[axis * 3 + axis] = 1;
+    r.m[a * 3 + b] = -1;
+    r.m[b * 3 + a] = 1;
+    return r;
+}
+
+constexpr void transform(const CubeRotation& r, const int* in, int* out) {
+    for (int i = 0; i < 3; ++i)
+        out[i] = r.m[i * 3] * in[0] + r.m[i * 3 + 1] * in[1] + r.m[i * 3 + 2] * in[2];
+}
+
+constexpr int cellIndex(const int* pos) {
+    return (pos[0] + 1) * 9 + (pos[1] + 1) * 3 + (pos[2] + 1);
+}
+
+constexpr void buildRotations(Geometry& g) {
+    CubeRotation identity = {{1, 0, 0, 0, 1, 0, 0, 0, 1}};
+    g.rotations[0] = identity;
+    int count = 1;
+    CubeRotation generators[2] = {axisQuarterTurn(0), axisQuarterTurn(1)};
+    for (int i = 0; i < count; ++i) {
+        for (const CubeRotation& generator : generators) {
+            CubeRotation r = multiply(generator, g.rotations[i]);
+            if (findRotation(g, r) < 0 && count < N_ROTATIONS) g.rotations[count++] = r;
+        }
+    }
+    for (int a = 0; a < N_ROTATIONS; ++a)
+        for (int b = 0; b < N_ROTATIONS; ++b)
+            g.composition[a][b] = findRotation(g, multiply(g.rotations[a], g.rotations[b]));
+    for (int face = 0; face < 6; ++face) {
+        CubeRotation r = axisQuarterTurn(faceAxis[face]);
+        // A clockwise face turn is -90 degrees around the outward normal.
+        if (faceSign[face] > 0) r = multiply(r, multiply(r, r));
+        g.faceTurnRotation[face] = findRotation(g, r);
+    }
+}
+
+// Follows a single piece through face turns in both the logical state and 3D space,
+// recording which rotation corresponds to each (slot, orientation) it can reach.
+template <int N>
+constexpr void tracePiece(Geometry& g, int piece, const int (&positions)[N][3], bool isCorner) {
+    int queue[N_ROTATIONS] = {};
+    CubeState states[N_ROTATIONS];
+    bool seen[N_ROTATIONS] = {false};
+    int head = 0, tail = 0;
+    queue[tail++] = 0;
+    seen[0] = true;
+    while (head < tail) {
+        int r = queue[head];
+        CubeState state = states[head++];
+        int pos[3] = {};
+        transform(g.rotations[r], positions[piece], pos);
+        for (int face = 0; face < 6; ++face) {
+            int next = r;
+            if (pos[faceAxis[face]] == faceSign[face])
+                next = g.composition[g.faceTurnRotation[face]][r];
+            CubeState moved = state.applied(makeMove(face, 1));
+            for (int slot = 0; slot < N; ++slot) {
+                if (isCorner && moved.cornerPiece(slot) == piece)
+                    g.cornerRotation[slot][piece][moved.cornerOrientation(slot)] = next;
+                if (!isCorner && moved.edgePiece(slot) == piece)
+                    g.edgeRotation[slot][piece][moved.edgeOrientation(slot)] = next;
+            }
+            if (!seen[next]) {
+                seen[next] = true;
+                states[tail] = moved;
+                queue[tail++] = next;
+            }
+        }
+    }
+}
+
+constexpr Geometry buildGeometry() {
+    Geometry g = {};
+    buildRotations(g);
+    for (int piece = 0; piece < 8; ++piece) {
+        g.cornerRotation[piece][piece][0] = 0;
+        tracePiece(g, piece, cornerPositions, true);
+    }
+    for (int piece = 0; piece < 12; ++piece) {
+        g.edgeRotation[piece][piece][0] = 0;
+        tracePiece(g, piece, edgePositions, false);
+    }
+    for (int slot = 0; slot < 8; ++slot) {
+        int cell = cellIndex(cornerPositions[slot]);
+        g.gridCells[cell][0] = 1; g.gridCells[cell][1] = slot;
+    }
+    for (int slot = 0; slot < 12; ++slot) {
+        int cell = cellIndex(edgePositions[slot]);
+        g.gridCells[cell][0] = 2; g.gridCells[cell][1] = slot;
+    }
+    return g;
+}
+
+constexpr Geometry geometry = buildGeometry();
+
+} // namespace
+
+const CubeRotation& cubeRotation(int index) {
+    return geometry.rotations[index];
+}
+
+int composeRotations(int a, int b) {
+    return geometry.composition[a][b];
+}
+
+int moveRotation(int move) {
+    int quarter = geometry.faceTurnRotation[moveFace(move)], r = quarter;
+    for (int power = 1; power < movePower(move); ++power) r = geometry.composition[quarter][r];
+    return r;
+}
+
+int cubieRotation(const CubeState& state, int x, int y, int z) {
+    const int* cell = geometry.gridCells[x * 9 + y * 3 + z];
+    if (cell[0] == 1)
+        return geometry.cornerRotation[cell[1]][state.cornerPiece(cell[1])][state.cornerOrientation(cell[1])];
+    if (cell[0] == 2)
+        return geometry.edgeRotation[cell[1]][state.edgePiece(cell[1])][state.edgeOrientation(cell[1])];
+    return 0;
+}
@@ -0,0 +1,324 @@
+#include "FrameProfiler.h"
+#include "RenderCounters.h"
+#include <algorithm>
+
+namespace {
+
+const char* const SECTION_NAMES[3] = {"update", "draw", "swap"};
+
+// Overlay panel, in pixels from the bottom-left corner
+const float PANEL_MARGIN = 10.0f;
+const float PANEL_WIDTH = 300.0f;
+const float PANEL_HEIGHT = 120.0f;
+const float BUDGET_MS = 1000.0f / 60.0f;
+
+} // namespace
+
+FrameProfiler::FrameProfiler()
+    : origin(Clock::now()), history(HISTORY), frameIndex(0), frameCount(0),
+      nextQuery(0), activeQuery(-1), timerQueries(false),
+      trace(nullptr), traceJson(false), firstTraceEvent(true), nextTraceFrame(0),
+      overlayVAO(0), overlayVBO(0), overlayProgram(0), colorLocation(-1) {
+    for (int i = 0; i < QUERY_RING; ++i) {
+        queries[i] = 0;
+        queryFrame[i] = 0;
+        queryBusy[i] = false;
+    }
+}
+
+FrameProfiler::~FrameProfiler() {
+    finishTrace(); // Without GL: the context may be gone by now
+}
+
+void FrameProfiler::setup() {
+    // Timer queries are core in 3.3, but a driver may still have no timer behind them
+    GLint bits = 0;
+    glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &bits);
+    timerQueries = bits > 0;
+    if (timerQueries) glGenQueries(QUERY_RING, queries);
+
+    glGenVertexArrays(1, &overlayVAO);
+    glGenBuffers(1, &overlayVBO);
+    glBindVertexArray(overlayVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, overlayVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+}
+
+void FrameProfiler::cleanup() {
+    if (timerQueries) {
+        if (activeQuery >= 0) glEndQuery(GL_TIME_ELAPSED);
+        glDeleteQueries(QUERY_RING, queries);
+        timerQueries = false;
+    }
+    activeQuery = -1;
+    for (int i = 0; i < QUERY_RING; ++i) queryBusy[i] = false;
+    glDeleteBuffers(1, &overlayVBO);
+    glDeleteVertexArrays(1, &overlayVAO);
+    overlayVBO = overlayVAO = 0;
+}
+
+bool FrameProfiler::openTrace(const std::string& path) {
+    closeTrace();
+    trace = std::fopen(path.c_str(), "w");
+    if (!trace) return false;
+    traceJson = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    nextTraceFrame = frameCount;
+    if (traceJson) {
+        std::fputs("{\"traceEvents\":[\n"
+                   "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n"
+                   "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU draw (at its CPU start)\"}}",
+                   trace);
+        firstTraceEvent = false;
+    } else {
+        std::fputs("frame,start_ms,update_ms,draw_ms,swap_ms,frame_ms,gpu_ms,draw_calls,uniform_uploads\n", trace);
+    }
+    return true;
+}
+
+void FrameProfiler::closeTrace() {
+    if (!trace) return;
+    if (timerQueries) collectQueries(true); // The last few frames' GPU times
+    finishTrace();
+}
+
+void FrameProfiler::finishTrace() {
+    if (!trace) return;
+    writeTrace(true);
+    if (traceJson) std::fputs("\n]}\n", trace);
+    std::fclose(trace);
+    trace = nullptr;
+}
+
+float FrameProfiler::millisecondsBetween(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<float, std::milli>(to - from).count();
+}
+
+void FrameProfiler::beginFrame() {
+    frameStart = Clock::now();
+    frameIndex = frameCount;
+    if (timerQueries) collectQueries(false);
+
+    Frame& f = frame(frameIndex);
+    f.index = frameIndex;
+    f.startMs = std::chrono::duration<double, std::milli>(frameStart - origin).count();
+    for (int i = 0; i < 3; ++i) f.sectionStartMs[i] = 0.0f;
+    for (int i = 0; i < N_METRICS; ++i) f.ms[i] = 0.0f;
+    f.ms[GPU] = -1.0f;
+    f.drawCalls = f.uniformUploads = 0;
+    f.gpuPending = false;
+    RenderCounters::reset();
+}
+
+void FrameProfiler::begin(Metric section) {
+    sectionStart[section] = Clock::now();
+    frame(frameIndex).sectionStartMs[section] = millisecondsBetween(frameStart, sectionStart[section]);
+    if (section == DRAW && timerQueries && !queryBusy[nextQuery]) {
+        activeQuery = nextQuery;
+        glBeginQuery(GL_TIME_ELAPSED, queries[activeQuery]);
+    }
+}
+
+void FrameProfiler::end(Metric section) {
+    Frame& f = frame(frameIndex);
+    if (section == DRAW) {
+        if (activeQuery >= 0) {
+            glEndQuery(GL_TIME_ELAPSED);
+            queryBusy[activeQuery] = true;
+            queryFrame[activeQuery] = frameIndex;
+            f.gpuPending = true;
+            nextQuery = (activeQuery + 1) % QUERY_RING;
+            activeQuery = -1;
+        }
+        // Counted here so that whatever is drawn after the section, such as the
+        // overlay, is left out
+        f.drawCalls = RenderCounters::drawCalls;
+        f.uniformUploads = RenderCounters::uniformUploads;
+    }
+    f.ms[section] += millisecondsBetween(sectionStart[section], Clock::now());
+}
+
+void FrameProfiler::endFrame() {
+    frame(frameIndex).ms[FRAME] = millisecondsBetween(frameStart, Clock::now());
+    ++frameCount;
+    if (trace) writeTrace(false);
+}
+
+void FrameProfiler::collectQueries(bool wait) {
+    // Oldest first, so that a wait only ever waits for the GPU to get further
+    for (int k = 0; k < QUERY_RING; ++k) {
+        int i = (nextQuery + k) % QUERY_RING;
+        if (!queryBusy[i]) continue;
+        if (!wait) {
+            GLint available = 0;
+            glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) continue;
+        }
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &nanoseconds);
+        queryBusy[i] = false;
+        Frame& f = frame(queryFrame[i]);
+        if (f.index == queryFrame[i]) { // Still in the history
+            f.ms[GPU] = (float)(nanoseconds / 1.0e6);
+            f.gpuPending = false;
+        }
+    }
+}
+
+void FrameProfiler::writeTrace(bool all) {
+    // In frame order; a frame waits for its GPU time unless it is about to leave the history
+    for (; nextTraceFrame < frameCount; ++nextTraceFrame) {
+        const Frame& f = frame(nextTraceFrame);
+        if (f.gpuPending && !all && frameCount - nextTraceFrame < HISTORY) break;
+        writeFrame(f);
+    }
+}
+
+void FrameProfiler::writeFrame(const Frame& f) {
+    if (!traceJson) {
+        std::fprintf(trace, "%llu,%.3f,%.4f,%.4f,%.4f,%.4f,", (unsigned long long)f.index, f.startMs,
+                     f.ms[UPDATE], f.ms[DRAW], f.ms[SWAP], f.ms[FRAME]);
+        if (f.ms[GPU] >= 0.0f) std::fprintf(trace, "%.4f", f.ms[GPU]);
+        std::fprintf(trace, ",%u,%u\n", f.drawCalls, f.uniformUploads);
+        return;
+    }
+
+    // Chrome trace events, in microseconds
+    double start = f.startMs * 1000.0;
+    std::fprintf(trace, ",\n{\"name\":\"frame %llu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,"
+                 "\"args\":{\"draw_calls\":%u,\"uniform_uploads\":%u}}",
+                 (unsigned long long)f.index, start, f.ms[FRAME] * 1000.0, f.drawCalls, f.uniformUploads);
+    for (int section = 0; section < 3; ++section) {
+        std::fprintf(trace, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                     SECTION_NAMES[section], start + f.sectionStartMs[section] * 1000.0, f.ms[section] * 1000.0);
+    }
+    if (f.ms[GPU] >= 0.0f) {
+        std::fprintf(trace, ",\n{\"name\":\"draw\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.3f,\"dur\":%.3f}",
+                     start + f.sectionStartMs[DRAW] * 1000.0, f.ms[GPU] * 1000.0);
+    }
+    std::fprintf(trace, ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,"
+                 "\"args\":{\"draw_calls\":%u,\"uniform_uploads\":%u}}",
+                 start, f.drawCalls, f.uniformUploads);
+}
+
+FrameProfiler::Stats FrameProfiler::stats(Metric metric) const {
+    samples.clear();
+    uint64_t first = frameCount > (uint64_t)HISTORY ? frameCount - HISTORY : 0;
+    for (uint64_t i = first; i < frameCount; ++i) {
+        float ms = history[i % HISTORY].ms[metric];
+        if (ms >= 0.0f) samples.push_back(ms);
+    }
+    Stats s = {0.0f, 0.0f, 0.0f, 0.0f, (int)samples.size()};
+    if (samples.empty()) return s;
+
+    // Nearest rank; each nth_element only sorts what the previous one left above it
+    auto rank = [&](float p) { return samples.begin() + (size_t)(p * (samples.size() - 1) + 0.5f); };
+    auto p50 = rank(0.50f), p95 = rank(0.95f), p99 = rank(0.99f);
+    std::nth_element(samples.begin(), p50, samples.end());
+    std::nth_element(p50, p95, samples.end());
+    std::nth_element(p95, p99, samples.end());
+    s.p50 = *p50;
+    s.p95 = *p95;
+    s.p99 = *p99;
+    s.max = *std::max_element(p99, samples.end());
+    return s;
+}
+
+std::string FrameProfiler::summary() const {
+    Stats frameStats = stats(FRAME);
+    Stats gpuStats = stats(GPU);
+    float update = stats(UPDATE).p95, draw = stats(DRAW).p95, swap = stats(SWAP).p95;
+    const Frame& last = history[(frameCount + HISTORY - 1) % HISTORY];
+
+    char text[256];
+    int length = std::snprintf(text, sizeof(text),
+        "frame p50 %.1f p95 %.1f p99 %.1f max %.1f ms | p95 update %.2f draw %.2f swap %.2f ms",
+        frameStats.p50, frameStats.p95, frameStats.p99, frameStats.max, update, draw, swap);
+    if (gpuStats.samples > 0 && length < (int)sizeof(text)) {
+        length += std::snprintf(text + length, sizeof(text) - length, " | gpu p50 %.2f p95 %.2f ms",
+                                gpuStats.p50, gpuStats.p95);
+    }
+    if (frameCount > 0 && length < (int)sizeof(text)) {
+        std::snprintf(text + length, sizeof(text) - length, " | %u draws, %u uniforms",
+                      last.drawCalls, last.uniformUploads);
+    }
+    return text;
+}
+
+void FrameProfiler::drawOverlay(Shader& shader, int viewportWidth, int viewportHeight) {
+    uint64_t count = std::min<uint64_t>(frameCount, HISTORY);
+    if (count < 2 || !overlayVAO) return;
+    if (overlayProgram != shader.ID) {
+        overlayProgram = shader.ID;
+        colorLocation = shader.lookUpLocation("u_color");
+    }
+
+    // Panel corners in normalized device coordinates; values above the top are clamped
+    Stats frameStats = stats(FRAME);
+    float scaleMs = std::max(2.0f * BUDGET_MS, frameStats.p99 * 1.25f);
+    float x0 = -1.0f + 2.0f * PANEL_MARGIN / viewportWidth;
+    float y0 = -1.0f + 2.0f * PANEL_MARGIN / viewportHeight;
+    float width = 2.0f * PANEL_WIDTH / viewportWidth;
+    float height = 2.0f * PANEL_HEIGHT / viewportHeight;
+    auto point = [&](uint64_t i, float ms) {
+        return glm::vec2(x0 + width * i / (HISTORY - 1), y0 + height * std::min(ms / scaleMs, 1.0f));
+    };
+
+    overlayVertices.clear();
+    overlayVertices.push_back(glm::vec2(x0, y0)); // Background
+    overlayVertices.push_back(glm::vec2(x0 + width, y0));
+    overlayVertices.push_back(glm::vec2(x0, y0 + height));
+    overlayVertices.push_back(glm::vec2(x0 + width, y0 + height));
+    const GLint framesFirst = 4;
+    uint64_t first = frameCount - count;
+    for (uint64_t i = 0; i < count; ++i) overlayVertices.push_back(point(i, history[(first + i) % HISTORY].ms[FRAME]));
+    const GLint gpuFirst = (GLint)overlayVertices.size();
+    float gpu = 0.0f; // Frames still waiting for theirs show the last known GPU time
+    for (uint64_t i = 0; i < count; ++i) {
+        float ms = history[(first + i) % HISTORY].ms[GPU];
+        if (ms >= 0.0f) gpu = ms;
+        overlayVertices.push_back(point(i, gpu));
+    }
+    const GLint linesFirst = (GLint)overlayVertices.size();
+    const float lines[4] = {BUDGET_MS, frameStats.p50, frameStats.p95, frameStats.p99};
+    for (float ms : lines) {
+        overlayVertices.push_back(point(0, ms));
+        overlayVertices.push_back(point(HISTORY - 1, ms));
+    }
+    const glm::vec4 lineColors[4] = {
+        glm::vec4(0.5f, 0.5f, 0.5f, 1.0f), // 60 Hz budget
+        glm::vec4(0.3f, 0.8f, 1.0f, 1.0f), // p50
+        glm::vec4(1.0f, 0.9f, 0.2f, 1.0f), // p95
+        glm::vec4(1.0f, 0.3f, 0.2f, 1.0f), // p99
+    };
+
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_BLEND);
+
+    shader.use();
+    glBindVertexArray(overlayVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, overlayVBO);
+    glBufferData(GL_ARRAY_BUFFER, overlayVertices.size() * sizeof(glm::vec2), overlayVertices.data(), GL_STREAM_DRAW);
+    shader.setVec4(colorLocation, glm::vec4(0.0f, 0.0f, 0.0f, 0.6f));
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    for (int i = 0; i < 4; ++i) {
+        shader.setVec4(colorLocation, lineColors[i]);
+        glDrawArrays(GL_LINES, linesFirst + 2 * i, 2);
+    }
+    if (timerQueries) {
+        shader.setVec4(colorLocation, glm::vec4(0.3f, 1.0f, 0.4f, 1.0f));
+        glDrawArrays(GL_LINE_STRIP, gpuFirst, (GLsizei)count);
+    }
+    shader.setVec4(colorLocation, glm::vec4(1.0f));
+    glDrawArrays(GL_LINE_STRIP, framesFirst, (GLsizei)count);
+    glBindVertexArray(0);
+
+    if (depthTest) glEnable(GL_DEPTH_TEST);
+    if (cullFace) glEnable(GL_CULL_FACE);
+    if (!blend) glDisable(GL_BLEND);
+}
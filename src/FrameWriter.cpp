@@ -0,0 +1,207 @@
+#include "FrameWriter.h"
+
+namespace {
+
+uint32_t crcTable[256];
+
+void buildCrcTable() {
+    for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        crcTable[n] = c;
+    }
+}
+
+uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) crc = crcTable[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+void putBigEndian(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back((uint8_t)(v >> 24));
+    out.push_back((uint8_t)(v >> 16));
+    out.push_back((uint8_t)(v >> 8));
+    out.push_back((uint8_t)v);
+}
+
+// A chunk is its length, type, data and CRC: beginChunk() leaves room for the length,
+// which endChunk() fills in once the data is there.
+size_t beginChunk(std::vector<uint8_t>& out, const char* type) {
+    size_t start = out.size();
+    putBigEndian(out, 0);
+    out.insert(out.end(), type, type + 4);
+    return start;
+}
+
+void endChunk(std::vector<uint8_t>& out, size_t start) {
+    uint32_t length = (uint32_t)(out.size() - start - 8);
+    for (int i = 0; i < 4; ++i) out[start + i] = (uint8_t)(length >> (24 - 8 * i));
+    putBigEndian(out, crc32(out.data() + start + 4, length + 4));
+}
+
+} // namespace
+
+FrameWriter::FrameWriter(Format format, const std::string& path, int width, int height, int fps)
+    : format(format), path(path), width(width), height(height), fps(fps),
+      file(nullptr), ownsFile(false), frames(0) {
+}
+
+FrameWriter::~FrameWriter() {
+    if (file) std::fflush(file);
+    if (ownsFile && file) std::fclose(file);
+}
+
+bool FrameWriter::parseFormat(const std::string& name, Format& format) {
+    if (name == "raw") format = RAW;
+    else if (name == "y4m") format = Y4M;
+    else if (name == "png") format = PNG;
+    else return false;
+    return true;
+}
+
+bool FrameWriter::open(std::string& error) {
+    if (format == Y4M && (width % 2 || height % 2)) {
+        error = "y4m needs an even width and height";
+        return false;
+    }
+    if (format == PNG) buildCrcTable();
+
+    if (path == "-") {
+        file = stdout;
+    } else if (format != PNG) {
+        file = std::fopen(path.c_str(), "wb");
+        ownsFile = true;
+        if (!file) {
+            error = "cannot open " + path;
+            return false;
+        }
+    } else if (path.find('%') == std::string::npos) {
+        error = "png output needs a pattern such as frames/%05d.png, or - for stdout";
+        return false;
+    }
+
+    if (format == Y4M)
+        std::fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+    return true;
+}
+
+bool FrameWriter::write(const uint8_t* rgba) {
+    FILE* out = file;
+    if (format == RAW) {
+        toRgb(rgba);
+    } else if (format == Y4M) {
+        toYuv420(rgba);
+        std::fputs("FRAME\n", out);
+    } else {
+        toPng(rgba);
+        if (!out) {
+            char name[4096];
+            std::snprintf(name, sizeof(name), path.c_str(), frames);
+            out = std::fopen(name, "wb");
+            if (!out) return false;
+        }
+    }
+    bool ok = std::fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+    if (out != file) ok = std::fclose(out) == 0 && ok;
+    ++frames;
+    return ok;
+}
+
+void FrameWriter::toRgb(const uint8_t* rgba) {
+    buffer.resize((size_t)width * height * 3);
+    uint8_t* out = buffer.data();
+    for (int y = height - 1; y >= 0; --y) {
+        const uint8_t* row = rgba + (size_t)y * width * 4;
+        for (int x = 0; x < width; ++x, out += 3) {
+            out[0] = row[4 * x];
+            out[1] = row[4 * x + 1];
+            out[2] = row[4 * x + 2];
+        }
+    }
+}
+
+void FrameWriter::toYuv420(const uint8_t* rgba) {
+    // Fixed-point BT.601, limited range; chroma averaged over each 2x2 block.
+    size_t lumaSize = (size_t)width * height;
+    buffer.resize(lumaSize * 3 / 2);
+    uint8_t* luma = buffer.data();
+    uint8_t* cb = luma + lumaSize;
+    uint8_t* cr = cb + lumaSize / 4;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = rgba + (size_t)(height - 1 - y) * width * 4;
+        for (int x = 0; x < width; ++x) {
+            int r = row[4 * x], g = row[4 * x + 1], b = row[4 * x + 2];
+            luma[(size_t)y * width + x] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        }
+    }
+    for (int y = 0; y < height; y += 2) {
+        const uint8_t* top = rgba + (size_t)(height - 1 - y) * width * 4;
+        const uint8_t* bottom = top - (size_t)width * 4;
+        for (int x = 0; x < width; x += 2) {
+            int r = top[4 * x] + top[4 * x + 4] + bottom[4 * x] + bottom[4 * x + 4];
+            int g = top[4 * x + 1] + top[4 * x + 5] + bottom[4 * x + 1] + bottom[4 * x + 5];
+            int b = top[4 * x + 2] + top[4 * x + 6] + bottom[4 * x + 2] + bottom[4 * x + 6];
+            size_t i = (size_t)(y / 2) * (width / 2) + x / 2;
+            cb[i] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 512) >> 10) + 128);
+            cr[i] = (uint8_t)(((112 * r - 94 * g - 18 * b + 512) >> 10) + 128);
+        }
+    }
+}
+
+void FrameWriter::toPng(const uint8_t* rgba) {
+    // RGB, 8 bits, no filtering, and zlib "stored" blocks: no compression, but no
+    // dependency either and next to no CPU time.
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    buffer.assign(signature, signature + 8);
+
+    size_t start = beginChunk(buffer, "IHDR");
+    putBigEndian(buffer, (uint32_t)width);
+    putBigEndian(buffer, (uint32_t)height);
+    const uint8_t format[5] = {8, 2, 0, 0, 0}; // Depth, RGB, deflate, filter method, no interlace
+    buffer.insert(buffer.end(), format, format + 5);
+    endChunk(buffer, start);
+
+    // Raw scanlines: a filter byte (none) then RGB, top row first.
+    std::vector<uint8_t> raw((size_t)(width * 3 + 1) * height);
+    uint8_t* out = raw.data();
+    for (int y = height - 1; y >= 0; --y) {
+        const uint8_t* row = rgba + (size_t)y * width * 4;
+        *out++ = 0;
+        for (int x = 0; x < width; ++x, out += 3) {
+            out[0] = row[4 * x];
+            out[1] = row[4 * x + 1];
+            out[2] = row[4 * x + 2];
+        }
+    }
+
+    start = beginChunk(buffer, "IDAT");
+    buffer.push_back(0x78); // zlib header: deflate, 32K window, no preset dictionary
+    buffer.push_back(0x01);
+    uint32_t a = 1, b = 0; // Adler-32
+    for (size_t offset = 0; offset < raw.size();) {
+        size_t length = raw.size() - offset < 65535 ? raw.size() - offset : 65535;
+        buffer.push_back(offset + length == raw.size() ? 1 : 0); // Final block flag, stored
+        buffer.push_back((uint8_t)length);
+        buffer.push_back((uint8_t)(length >> 8));
+        buffer.push_back((uint8_t)~length);
+        buffer.push_back((uint8_t)(~length >> 8));
+        buffer.insert(buffer.end(), raw.begin() + offset, raw.begin() + offset + length);
+        for (size_t i = offset; i < offset + length; ++i) {
+            a += raw[i];
+            b += a;
+            if ((i & 4095) == 4095) { // Well before b could overflow
+                a %= 65521;
+                b %= 65521;
+            }
+        }
+        a %= 65521;
+        b %= 65521;
+        offset += length;
+    }
+    putBigEndian(buffer, b << 16 | a);
+    endChunk(buffer, start);
+
+    start = beginChunk(buffer, "IEND");
+    endChunk(buffer, start);
+}
@@ -0,0 +1,57 @@
+#include "MoveQueue.h"
+#include <cstddef>
+
+MoveQueue::MoveQueue() {
+    Node* stub = new Node;
+    stub->next.store(nullptr, std::memory_order_relaxed);
+    stub->move = -1;
+    head.store(stub, std::memory_order_relaxed);
+    tail = stub;
+}
+
+MoveQueue::~MoveQueue() {
+    while (tail) {
+        Node* next = tail->next.load(std::memory_order_relaxed);
+        delete tail;
+        tail = next;
+    }
+}
+
+void MoveQueue::push(int move) {
+    Node* node = new Node;
+    node->next.store(nullptr, std::memory_order_relaxed);
+    node->move = move;
+    Node* previous = head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+}
+
+void MoveQueue::push(const std::vector<int>& moves) {
+    if (moves.empty()) return;
+    Node* first = new Node;
+    first->move = moves[0];
+    Node* last = first;
+    for (size_t i = 1; i < moves.size(); ++i) {
+        Node* node = new Node;
+        node->move = moves[i];
+        last->next.store(node, std::memory_order_relaxed);
+        last = node;
+    }
+    last->next.store(nullptr, std::memory_order_relaxed);
+    // The release store publishes the whole private chain with it.
+    Node* previous = head.exchange(last, std::memory_order_acq_rel);
+    previous->next.store(first, std::memory_order_release);
+}
+
+bool MoveQueue::pop(int& move) {
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (!next) return false;
+    move = next->move;
+    delete tail;
+    tail = next;
+    return true;
+}
+
+void MoveQueue::popAll(std::vector<int>& moves) {
+    int move;
+    while (pop(move)) moves.push_back(move);
+}
@@ -0,0 +1,162 @@
+#include "OffscreenRenderer.h"
+#include <EGL/eglext.h>
+#include <cstring>
+
+namespace {
+
+bool hasExtension(const char* extensions, const char* name) {
+    if (!extensions) return false;
+    size_t length = std::strlen(name);
+    for (const char* p = extensions; (p = std::strstr(p, name)) != nullptr; p += length)
+        if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0')) return true;
+    return false;
+}
+
+} // namespace
+
+OffscreenRenderer::OffscreenRenderer(int width, int height, int ringSize)
+    : frameWidth(width), frameHeight(height), ringSize(ringSize < 1 ? 1 : ringSize),
+      display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT),
+      framebuffer(0), colorBuffer(0), depthBuffer(0), nextBuffer(0), inFlight(0) {
+}
+
+OffscreenRenderer::~OffscreenRenderer() {
+    if (context != EGL_NO_CONTEXT) {
+        for (GLsync fence : fences)
+            if (fence) glDeleteSync(fence);
+        if (!pixelBuffers.empty()) glDeleteBuffers((GLsizei)pixelBuffers.size(), pixelBuffers.data());
+        glDeleteRenderbuffers(1, &colorBuffer);
+        glDeleteRenderbuffers(1, &depthBuffer);
+        glDeleteFramebuffers(1, &framebuffer);
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+    }
+    if (display != EGL_NO_DISPLAY) eglTerminate(display);
+}
+
+bool OffscreenRenderer::initialize(std::string& error) {
+    // 1. A display that needs no window system
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay) display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        error = "no EGL display";
+        return false;
+    }
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!hasExtension(extensions, "EGL_KHR_surfaceless_context")) {
+        error = "EGL display does not support surfaceless contexts";
+        return false;
+    }
+
+    // 2. An OpenGL 3.3 core context, current without any surface
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        error = "EGL has no desktop OpenGL";
+        return false;
+    }
+    const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = nullptr;
+    EGLint configs = 0;
+    eglChooseConfig(display, configAttributes, &config, 1, &configs);
+    if (configs == 0 && !hasExtension(extensions, "EGL_KHR_no_config_context")) {
+        error = "no EGL config for OpenGL";
+        return false;
+    }
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context = eglCreateContext(display, configs ? config : (EGLConfig)0, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        error = "cannot create an OpenGL 3.3 core context";
+        return false;
+    }
+
+    // 3. GLEW: glewInit() would look for a GLX or EGL drawable, so only load GL itself
+    glewExperimental = GL_TRUE;
+    if (glewContextInit() != GLEW_OK) {
+        error = "GLEW initialization failed";
+        return false;
+    }
+    while (glGetError() != GL_NO_ERROR) {}
+
+    // 4. The framebuffer frames are drawn into
+    glGenFramebuffers(1, &framebuffer);
+    glGenRenderbuffers(1, &colorBuffer);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, frameWidth, frameHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, frameWidth, frameHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        error = "framebuffer incomplete";
+        return false;
+    }
+
+    // 5. The readback ring
+    pixelBuffers.resize(ringSize);
+    fences.assign(ringSize, nullptr);
+    glGenBuffers(ringSize, pixelBuffers.data());
+    for (GLuint buffer : pixelBuffers) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)frameWidth * frameHeight * 4, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    return true;
+}
+
+void OffscreenRenderer::beginFrame() {
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, frameWidth, frameHeight);
+}
+
+void OffscreenRenderer::endFrame(const FrameCallback& onFrame) {
+    // The slot about to be reused holds the oldest frame: hand it over first.
+    if (inFlight == ringSize) {
+        deliver(nextBuffer, onFrame);
+        --inFlight;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[nextBuffer]);
+    glReadPixels(0, 0, frameWidth, frameHeight, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); // Into the buffer, not waiting
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    fences[nextBuffer] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush(); // Start the copy now rather than at the next wait
+
+    nextBuffer = (nextBuffer + 1) % ringSize;
+    ++inFlight;
+}
+
+void OffscreenRenderer::finish(const FrameCallback& onFrame) {
+    for (; inFlight > 0; --inFlight)
+        deliver((nextBuffer - inFlight + ringSize) % ringSize, onFrame);
+}
+
+void OffscreenRenderer::deliver(int slot, const FrameCallback& onFrame) {
+    if (fences[slot]) {
+        glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(fences[slot]);
+        fences[slot] = nullptr;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[slot]);
+    const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)frameWidth * frameHeight * 4, GL_MAP_READ_BIT);
+    if (pixels) {
+        onFrame(static_cast<const uint8_t*>(pixels));
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
@@ -0,0 +1,401 @@
+#include "OptimalSolver.h"
+#include "Coordinates.h"
+#include "PruningTable.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+const int MAX_EDGE_GROUP_SIZE = 7;
+const uint64_t N_CORNER_ENTRIES = (uint64_t)N_CORNER_PERM * N_TWIST;
+
+// Where a move takes an edge, indexed by (orientation << 4) | slot.
+constexpr MoveTable<uint8_t, 32> edgeLocationMove = [] {
+    MoveTable<uint8_t, 32> table{};
+    for (int m = 0; m < N_MOVES; ++m) {
+        CubeState moved = CubeState().applied(m);
+        for (int slot = 0; slot < 12; ++slot) {
+            int piece = moved.edgePiece(slot);
+            for (int flip = 0; flip < 2; ++flip)
+                table.move[flip << 4 | piece][m] = (uint8_t)((flip ^ moved.edgeOrientation(slot)) << 4 | slot);
+        }
+    }
+    return table;
+}();
+
+struct OptimalTables {
+    CubeState diagonal[3];         // Rotations about the URF-DBL diagonal by 0, 120 and 240 degrees
+    int conjugateMove[3][N_MOVES]; // diagonal[k] * move * diagonal[k]^-1
+    uint16_t cornerPermMove[N_CORNER_PERM][N_MOVES]; // Twists use Coordinates.h's twistMoveTable
+
+    PruningTable corners;       // cornerPerm * N_TWIST + twist
+    PruningTable edgeGroups[2]; // The first and the last edgeGroupSize edges, see edgeGroupIndex
+    uint64_t edgeGroupRoot[2];  // Index of each group solved
+};
+
+bool compactTables = true;     // MOD3 tables rather than PACKED4, see setCompactTables
+bool largeEdgeTables = false; // Seven edges per group rather than six, see setLargeEdgeTables
+
+// Edges per group in the tables in use: six, UR..DF and DL..BR, or seven, UR..DL and
+// DF..BR, which share DF and DL. Fixed once the tables are built.
+int edgeGroupSize = 6;
+
+// First edge of each group, in CubeState's edge order.
+int edgeGroupStart(int group) {
+    return group * (12 - edgeGroupSize);
+}
+
+// Index of a group's edges given their locations: the ordered slots they occupy, ranked
+// as a partial permutation, followed by their orientation bits.
+uint64_t edgeGroupIndex(const uint8_t* locations) {
+    uint64_t rank = 0;
+    int used = 0, flips = 0;
+    for (int i = 0; i < edgeGroupSize; ++i) {
+        int slot = locations[i] & 0x0F;
+        int smaller = __builtin_popcount(used & ((1 << slot) - 1));
+        rank = rank * (12 - i) + (slot - smaller);
+        used |= 1 << slot;
+        flips = flips << 1 | locations[i] >> 4;
+    }
+    return rank << edgeGroupSize | flips;
+}
+
+void decodeEdgeGroup(uint64_t index, uint8_t* locations) {
+    int flips = (int)(index & ((1 << edgeGroupSize) - 1));
+    uint64_t rank = index >> edgeGroupSize;
+    int digits[MAX_EDGE_GROUP_SIZE];
+    for (int i = edgeGroupSize - 1; i >= 0; --i) {
+        digits[i] = (int)(rank % (12 - i));
+        rank /= 12 - i;
+    }
+    int used = 0;
+    for (int i = 0; i < edgeGroupSize; ++i) {
+        int slot = 0;
+        for (int k = digits[i]; ; ++slot)
+            if (!(used >> slot & 1) && k-- == 0) break;
+        used |= 1 << slot;
+        int flip = flips >> (edgeGroupSize - 1 - i) & 1;
+        locations[i] = (uint8_t)(flip << 4 | slot);
+    }
+}
+
+int cornerNeighbors(const OptimalTables& t, uint64_t i, uint64_t* out) {
+    int perm = (int)(i / N_TWIST), twist = (int)(i % N_TWIST);
+    for (int m = 0; m < N_MOVES; ++m)
+        out[m] = (uint64_t)t.cornerPermMove[perm][m] * N_TWIST + twistMoveTable[twist][m];
+    return N_MOVES;
+}
+
+int edgeGroupNeighbors(uint64_t i, uint64_t* out) {
+    uint8_t locations[MAX_EDGE_GROUP_SIZE], moved[MAX_EDGE_GROUP_SIZE];
+    decodeEdgeGroup(i, locations);
+    for (int m = 0; m < N_MOVES; ++m) {
+        for (int k = 0; k < edgeGroupSize; ++k) moved[k] = edgeLocationMove[locations[k]][m];
+        out[m] = edgeGroupIndex(moved);
+    }
+    return N_MOVES;
+}
+
+OptimalTables* buildTables() {
+    OptimalTables* t = new OptimalTables;
+    // Cubie form of the 120 degree rotation taking U to F, R to U and F to R.
+    const uint8_t rotationCorners[8] = {0x10, 0x24, 0x15, 0x21, 0x23, 0x17, 0x26, 0x12};
+    const uint8_t rotationEdges[12] = {0x11, 0x08, 0x15, 0x09, 0x13, 0x0B, 0x17, 0x0A, 0x10, 0x14, 0x16, 0x12};
+    CubeState rotation;
+    for (int i = 0; i < 8; ++i) rotation.corners[i] = rotationCorners[i];
+    for (int i = 0; i < 12; ++i) rotation.edges[i] = rotationEdges[i];
+    t->diagonal[1] = rotation;
+    t->diagonal[2] = rotation;
+    t->diagonal[2].multiply(rotation);
+    for (int k = 0; k < 3; ++k) {
+        CubeState inverse = t->diagonal[k].inverse();
+        for (int m = 0; m < N_MOVES; ++m) {
+            CubeState conjugate = t->diagonal[k];
+            conjugate.multiply(CubeState().applied(m));
+            conjugate.multiply(inverse);
+            for (int n = 0; n < N_MOVES; ++n)
+                if (conjugate == CubeState().applied(n)) t->conjugateMove[k][m] = n;
+        }
+    }
+
+    buildMoveTable(t->cornerPermMove, N_CORNER_PERM, allMoves, setCornerPerm, getCornerPerm);
+
+    // Each encoding has its own files, so both can live in one table directory.
+    PruningTable::Encoding encoding = compactTables ? PruningTable::MOD3 : PruningTable::PACKED4;
+    std::string suffix = compactTables ? " mod3 v1" : " v1";
+    t->corners.loadOrGenerate("optimal/corners" + suffix, N_CORNER_ENTRIES, 0,
+        [t](uint64_t i, uint64_t* out) { return cornerNeighbors(*t, i, out); }, encoding);
+
+    edgeGroupSize = largeEdgeTables ? 7 : 6;
+    uint64_t edgeGroupEntries = (uint64_t)1 << edgeGroupSize; // 12! / (12 - size)! * 2^size
+    for (int i = 0; i < edgeGroupSize; ++i) edgeGroupEntries *= 12 - i;
+    for (int group = 0; group < 2; ++group) {
+        uint8_t solved[MAX_EDGE_GROUP_SIZE];
+        for (int i = 0; i < edgeGroupSize; ++i) solved[i] = (uint8_t)(edgeGroupStart(group) + i);
+        t->edgeGroupRoot[group] = edgeGroupIndex(solved);
+        std::string layout = (largeEdgeTables ? "optimal/edges7-" : "optimal/edges-") + std::to_string(group) + suffix;
+        t->edgeGroups[group].loadOrGenerate(layout, edgeGroupEntries, t->edgeGroupRoot[group],
+            edgeGroupNeighbors, encoding);
+    }
+    return t;
+}
+
+const OptimalTables& tables() {
+    static const OptimalTables* instance = buildTables();
+    return *instance;
+}
+
+// Every pattern database distance of a search root, which has no parent to recover
+// MOD3 distances from. Returns false if a table has no distance for the root.
+template <class Node>
+bool rootDistances(const OptimalTables& t, Node& node, int views) {
+    for (int v = 0; v < views; ++v) {
+        int c = t.corners.rootDistance((uint64_t)node.cornerPerm[v] * N_TWIST + node.twist[v], 0,
+            [&t](uint64_t i, uint64_t* out) { return cornerNeighbors(t, i, out); });
+        if (c < 0) return false;
+        node.cornerDistance[v] = (uint8_t)c;
+        for (int group = 0; group < 2; ++group) {
+            int e = t.edgeGroups[group].rootDistance(
+                edgeGroupIndex(node.edgeLocations[v] + edgeGroupStart(group)), t.edgeGroupRoot[group],
+                edgeGroupNeighbors);
+            if (e < 0) return false;
+            node.edgeDistance[v][group] = (uint8_t)e;
+        }
+    }
+    return true;
+}
+
+// Corner distances of `child`, one move from `parent`, giving up as soon as one exceeds
+// `limit` (the child is then pruned, and its distances are never needed). Returns the
+// largest. Corners are checked first since they prune most often.
+template <class Node>
+int cornerDistances(const OptimalTables& t, const Node& parent, Node& child, int views, int limit) {
+    int h = 0;
+    for (int v = 0; v < views && h <= limit; ++v) {
+        int c = t.corners.distance((uint64_t)child.cornerPerm[v] * N_TWIST + child.twist[v], parent.cornerDistance[v]);
+        child.cornerDistance[v] = (uint8_t)c;
+        if (c > h) h = c;
+    }
+    return h;
+}
+
+// Likewise for the edge groups.
+template <class Node>
+int edgeDistances(const OptimalTables& t, const Node& parent, Node& child, int views, int limit) {
+    int h = 0;
+    for (int v = 0; v < views && h <= limit; ++v) {
+        for (int group = 0; group < 2 && h <= limit; ++group) {
+            int e = t.edgeGroups[group].distance(edgeGroupIndex(child.edgeLocations[v] + edgeGroupStart(group)),
+                                                 parent.edgeDistance[v][group]);
+            child.edgeDistance[v][group] = (uint8_t)e;
+            if (e > h) h = e;
+        }
+    }
+    return h;
+}
+
+// Largest pattern database bound over all views.
+template <class Node>
+int distanceEstimate(const Node& node, int views) {
+    int h = 0;
+    for (int v = 0; v < views; ++v) {
+        h = std::max(h, (int)node.cornerDistance[v]);
+        h = std::max(h, (int)std::max(node.edgeDistance[v][0], node.edgeDistance[v][1]));
+    }
+    return h;
+}
+
+} // namespace
+
+void OptimalSolver::setCompactTables(bool compact) {
+    compactTables = compact;
+}
+
+void OptimalSolver::setLargeEdgeTables(bool large) {
+    largeEdgeTables = large;
+}
+
+OptimalSolver::OptimalSolver(int threads) : nodes(0) {
+    tables();
+    // Resolve "every core" first: on a single core a pool would only add task overhead.
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads > 1) pool.reset(new WorkStealingPool(threads));
+}
+
+bool OptimalSolver::solve(const CubeState& cube, std::vector<int>& solution) {
+    return solve(cube, solution, nullptr);
+}
+
+bool OptimalSolver::solve(const CubeState& cube, std::vector<int>& solution, const std::atomic<bool>* cancel) {
+    solution.clear();
+    nodes = 0;
+    if (!cube.isValid()) return false;
+
+    const OptimalTables& t = tables();
+    Node root;
+    for (int v = 0; v < N_VIEWS; ++v) {
+        CubeState view = t.diagonal[v];
+        view.multiply(cube);
+        view.multiply(t.diagonal[v].inverse());
+        root.cornerPerm[v] = getCornerPerm(view);
+        root.twist[v] = getTwist(view);
+        for (int slot = 0; slot < 12; ++slot)
+            root.edgeLocations[v][view.edgePiece(slot)] = (uint8_t)(view.edgeOrientation(slot) << 4 | slot);
+    }
+    if (!rootDistances(t, root, N_VIEWS)) {
+        std::fprintf(stderr, "OptimalSolver: no pattern database distance for this cube, a table is corrupt\n");
+        return false;
+    }
+
+    for (int bound = distanceEstimate(root, N_VIEWS); bound <= MAX_DEPTH; ++bound) {
+        if (pool && bound >= MIN_PARALLEL_BOUND) {
+            if (searchParallel(root, bound, solution, cancel)) return true;
+            if (cancel && cancel->load(std::memory_order_relaxed)) return false;
+            continue;
+        }
+        Search s;
+        s.nodes = 0;
+        s.stop = nullptr;
+        s.cancel = cancel;
+        bool found = search(s, root, 0, bound);
+        nodes += s.nodes;
+        if (found) {
+            solution.assign(s.path, s.path + s.solutionLength);
+            return true;
+        }
+        if (cancel && cancel->load(std::memory_order_relaxed)) return false;
+    }
+    return false;
+}
+
+void OptimalSolver::collectPrefixes(const Node& node, int depth, int bound, Prefix& prefix,
+                                    std::vector<Prefix>& prefixes) {
+    if (depth == SPLIT_DEPTH) {
+        prefix.node = node;
+        prefixes.push_back(prefix);
+        return;
+    }
+    const OptimalTables& t = tables();
+    int previousFace = depth > 0 ? moveFace(prefix.path[depth - 1]) : -1;
+    Node child;
+    for (int m = 0; m < N_MOVES; ++m) {
+        int face = moveFace(m);
+        if (face == previousFace || face == previousFace - 3) continue;
+        for (int v = 0; v < N_VIEWS; ++v) {
+            int vm = t.conjugateMove[v][m];
+            child.cornerPerm[v] = t.cornerPermMove[node.cornerPerm[v]][vm];
+            child.twist[v] = twistMoveTable[node.twist[v]][vm];
+            for (int e = 0; e < 12; ++e) child.edgeLocations[v][e] = edgeLocationMove[node.edgeLocations[v][e]][vm];
+        }
+        int limit = bound - depth - 1;
+        if (cornerDistances(t, node, child, N_VIEWS, limit) > limit) continue;
+        if (edgeDistances(t, node, child, N_VIEWS, limit) > limit) continue;
+        prefix.path[depth] = m;
+        collectPrefixes(child, depth + 1, bound, prefix, prefixes);
+    }
+}
+
+bool OptimalSolver::searchParallel(const Node& root, int bound, std::vector<int>& solution,
+                                   const std::atomic<bool>* cancel) {
+    // Iterations below MIN_PARALLEL_BOUND have already ruled out solutions shorter than
+    // the prefixes, so every solution of this bound extends one of them.
+    std::vector<Prefix> prefixes;
+    Prefix prefix;
+    collectPrefixes(root, 0, bound, prefix, prefixes);
+
+    std::atomic<bool> solved(false);
+    std::atomic<uint64_t> taskNodes(0);
+    std::mutex solutionMutex;
+    for (const Prefix& p : prefixes) {
+        pool->submit([&, bound] {
+            // Tasks still queued when the solution turns up return without searching.
+            if (solved.load(std::memory_order_relaxed)) return;
+            if (cancel && cancel->load(std::memory_order_relaxed)) return;
+            Search s;
+            s.nodes = 0;
+            s.stop = &solved;
+            s.cancel = cancel;
+            for (int d = 0; d < SPLIT_DEPTH; ++d) s.path[d] = p.path[d];
+            if (search(s, p.node, SPLIT_DEPTH, bound)) {
+                std::lock_guard<std::mutex> lock(solutionMutex);
+                if (!solved.load(std::memory_order_relaxed)) {
+                    solution.assign(s.path, s.path + s.solutionLength);
+                    solved.store(true, std::memory_order_relaxed);
+                }
+            }
+            taskNodes += s.nodes;
+        });
+    }
+    pool->wait();
+    nodes += taskNodes + prefixes.size();
+    return solved.load();
+}
+
+bool OptimalSolver::search(Search& s, const Node& node, int depth, int bound) {
+    const OptimalTables& t = tables();
+    // Polled once per node: relaxed loads of lines that are only written once.
+    if (s.stop && s.stop->load(std::memory_order_relaxed)) return false;
+    if (s.cancel && s.cancel->load(std::memory_order_relaxed)) return false;
+    ++s.nodes;
+    int h = distanceEstimate(node, N_VIEWS);
+    if (h == 0) {
+        // Corners and both edge groups are home, so the cube is solved.
+        s.solutionLength = depth;
+        return true;
+    }
+    if (depth + h > bound) return false;
+
+    int previousFace = depth > 0 ? moveFace(s.path[depth - 1]) : -1;
+    if (depth + 1 == bound) {
+        // Children must be solved outright, which needs no table lookups.
+        for (int m = 0; m < N_MOVES; ++m) {
+            int face = moveFace(m);
+            if (face == previousFace || face == previousFace - 3) continue;
+            ++s.nodes;
+            if (t.cornerPermMove[node.cornerPerm[0]][m] != 0 || twistMoveTable[node.twist[0]][m] != 0) continue;
+            bool solved = true;
+            for (int e = 0; e < 12 && solved; ++e) solved = edgeLocationMove[node.edgeLocations[0][e]][m] == e;
+            if (solved) {
+                s.path[depth] = m;
+                s.solutionLength = bound;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Node child;
+    for (int m = 0; m < N_MOVES; ++m) {
+        int face = moveFace(m);
+        // Same-face repeats collapse into one move, and opposite faces commute,
+        // so only one order of each opposite pair is searched.
+        if (face == previousFace || face == previousFace - 3) continue;
+        // Corner bounds first: most children are cut off before their edges are moved.
+        int limit = bound - depth - 1, h = 0;
+        for (int v = 0; v < N_VIEWS && h <= limit; ++v) {
+            int vm = t.conjugateMove[v][m];
+            child.cornerPerm[v] = t.cornerPermMove[node.cornerPerm[v]][vm];
+            child.twist[v] = twistMoveTable[node.twist[v]][vm];
+            int c = t.corners.distance((uint64_t)child.cornerPerm[v] * N_TWIST + child.twist[v], node.cornerDistance[v]);
+            child.cornerDistance[v] = (uint8_t)c;
+            h = std::max(h, c);
+        }
+        if (h > limit) {
+            ++s.nodes;
+            continue;
+        }
+        for (int v = 0; v < N_VIEWS; ++v) {
+            int vm = t.conjugateMove[v][m];
+            for (int e = 0; e < 12; ++e) child.edgeLocations[v][e] = edgeLocationMove[node.edgeLocations[v][e]][vm];
+        }
+        if (edgeDistances(t, node, child, N_VIEWS, limit) > limit) {
+            ++s.nodes;
+            continue;
+        }
+        s.path[depth] = m;
+        if (search(s, child, depth + 1, bound)) return true;
+    }
+    return false;
+}
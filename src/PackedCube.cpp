@@ -0,0 +1,201 @@
+#include "PackedCube.h"
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PACKED_CUBE_X86 1
+#endif
+
+namespace {
+
+const int CORNER_LANE = 16;
+
+// Per move: lane-relative source byte, orientation delta and wrap threshold of each byte.
+struct alignas(32) MoveMask
+{
+    uint8_t source[32];
+    uint8_t add[32];
+    uint8_t wrap[32];
+};
+
+// Any permutation works like a move: the permuted solved cube holds, in each slot, the
+// slot its piece comes from and the twist it picks up.
+constexpr void buildMask(const CubeState& moved, MoveMask& k) {
+    for (int i = 0; i < 32; ++i) {
+        k.source[i] = (uint8_t)(i & 15);
+        k.add[i] = 0;
+        k.wrap[i] = i < CORNER_LANE ? 0x20 : 0x30;
+    }
+    for (int i = 0; i < 12; ++i) {
+        k.source[i] = (uint8_t)moved.edgePiece(i);
+        k.add[i] = (uint8_t)(moved.edgeOrientation(i) << 4);
+    }
+    for (int i = 0; i < 8; ++i) {
+        k.source[CORNER_LANE + i] = (uint8_t)moved.cornerPiece(i);
+        k.add[CORNER_LANE + i] = (uint8_t)(moved.cornerOrientation(i) << 4);
+    }
+}
+
+struct MoveMasks
+{
+    MoveMask move[N_MOVES];
+};
+
+// Built at compile time from CubeState's constexpr moves.
+constexpr MoveMasks masks = [] {
+    MoveMasks all = {};
+    for (int m = 0; m < N_MOVES; ++m) buildMask(CubeState().applied(m), all.move[m]);
+    return all;
+}();
+
+const MoveMask* moveMasks() {
+    return masks.move;
+}
+
+void applyScalar(PackedCube* cubes, int count, const MoveMask& k) {
+    for (int c = 0; c < count; ++c) {
+        // Only the 20 piece bytes; padding maps to itself and stays zero.
+        uint8_t* bytes = cubes[c].bytes;
+        uint8_t edges[12], corners[8];
+        for (int i = 0; i < 12; ++i) edges[i] = bytes[k.source[i]] ^ k.add[i];
+        for (int i = 0; i < 8; ++i) {
+            uint8_t v = (uint8_t)(bytes[CORNER_LANE + k.source[CORNER_LANE + i]] + k.add[CORNER_LANE + i]);
+            corners[i] = v >= 0x30 ? (uint8_t)(v - 0x30) : v;
+        }
+        std::memcpy(bytes, edges, sizeof(edges));
+        std::memcpy(bytes + CORNER_LANE, corners, sizeof(corners));
+    }
+}
+
+void expandScalar(const PackedCube& cube, PackedCube* children) {
+    for (int m = 0; m < N_MOVES; ++m) {
+        children[m] = cube;
+        applyScalar(&children[m], 1, moveMasks()[m]);
+    }
+}
+
+#ifdef PACKED_CUBE_X86
+
+// Bytes below the threshold wrap to 0xD0 and up when it is subtracted, so the unsigned
+// minimum keeps them as they are and reduces the others.
+__attribute__((target("avx2")))
+inline __m256i moveAvx2(__m256i v, const MoveMask& k) {
+    v = _mm256_shuffle_epi8(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(k.source)));
+    v = _mm256_add_epi8(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(k.add)));
+    return _mm256_min_epu8(v, _mm256_sub_epi8(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(k.wrap))));
+}
+
+__attribute__((target("avx2")))
+void applyAvx2(PackedCube* cubes, int count, const MoveMask& k) {
+    for (int c = 0; c < count; ++c) {
+        __m256i* p = reinterpret_cast<__m256i*>(cubes[c].bytes);
+        _mm256_store_si256(p, moveAvx2(_mm256_load_si256(p), k));
+    }
+}
+
+__attribute__((target("avx2")))
+void expandAvx2(const PackedCube& cube, PackedCube* children) {
+    const MoveMask* all = moveMasks();
+    __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(cube.bytes));
+    for (int m = 0; m < N_MOVES; ++m)
+        _mm256_store_si256(reinterpret_cast<__m256i*>(children[m].bytes), moveAvx2(v, all[m]));
+}
+
+bool hasAvx2() {
+    __builtin_cpu_init(); // May run before the constructor that normally does this
+    return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+bool hasAvx2() {
+    return false;
+}
+
+#endif
+
+struct Kernel
+{
+    const char* name;
+    void (*apply)(PackedCube*, int, const MoveMask&);
+    void (*expand)(const PackedCube&, PackedCube*);
+};
+
+const Kernel scalarKernel = {"scalar", applyScalar, expandScalar};
+#ifdef PACKED_CUBE_X86
+const Kernel avx2Kernel = {"avx2", applyAvx2, expandAvx2};
+#endif
+
+const Kernel* selectKernel() {
+#ifdef PACKED_CUBE_X86
+    if (hasAvx2()) return &avx2Kernel;
+#endif
+    return &scalarKernel;
+}
+
+// usePackedKernel may switch kernels while solver threads are running. Either kernel
+// gives the same results, so callers only need the pointer itself to be read whole.
+std::atomic<const Kernel*> kernel(selectKernel());
+
+const Kernel& currentKernel() {
+    return *kernel.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+PackedCube::PackedCube() : PackedCube(CubeState()) {
+}
+
+PackedCube::PackedCube(const CubeState& state) {
+    std::memset(bytes, 0, sizeof(bytes));
+    std::memcpy(bytes, state.edges, sizeof(state.edges));
+    std::memcpy(bytes + CORNER_LANE, state.corners, sizeof(state.corners));
+}
+
+CubeState PackedCube::toState() const {
+    CubeState state;
+    std::memcpy(state.edges, bytes, sizeof(state.edges));
+    std::memcpy(state.corners, bytes + CORNER_LANE, sizeof(state.corners));
+    return state;
+}
+
+bool PackedCube::operator==(const PackedCube& other) const {
+    return std::memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+}
+
+void applyMove(PackedCube& cube, int move) {
+    currentKernel().apply(&cube, 1, moveMasks()[move]);
+}
+
+void applyMove(PackedCube* cubes, int count, int move) {
+    currentKernel().apply(cubes, count, moveMasks()[move]);
+}
+
+void applyPermutation(PackedCube* cubes, int count, const CubeState& effect) {
+    MoveMask k = {};
+    buildMask(effect, k);
+    currentKernel().apply(cubes, count, k);
+}
+
+void expandMoves(const PackedCube& cube, PackedCube* children) {
+    currentKernel().expand(cube, children);
+}
+
+const char* packedKernelName() {
+    return currentKernel().name;
+}
+
+bool usePackedKernel(const char* name) {
+    if (std::strcmp(name, scalarKernel.name) == 0) {
+        kernel.store(&scalarKernel, std::memory_order_relaxed);
+        return true;
+    }
+#ifdef PACKED_CUBE_X86
+    if (std::strcmp(name, avx2Kernel.name) == 0 && hasAvx2()) {
+        kernel.store(&avx2Kernel, std::memory_order_relaxed);
+        return true;
+    }
+#endif
+    return false;
+}
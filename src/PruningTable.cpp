@@ -0,0 +1,204 @@
+#include "PruningTable.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char MAGIC[8] = {'R', 'C', 'S', 'P', 'T', 'B', 'L', '\0'};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t bitsPerEntry;
+    uint64_t entryCount;
+    uint64_t payloadSize;
+    uint64_t payloadHash;
+    char layout[64];
+};
+
+static_assert(sizeof(FileHeader) == 104, "FileHeader must match the documented layout");
+static_assert(PruningTable::HEADER_SIZE == 4096, "HEADER_SIZE is part of the file format");
+
+uint64_t fnv1a(const uint8_t* data, uint64_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (uint64_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::string& tableDirectory() {
+    static std::string directory = [] {
+        const char* env = std::getenv("CUBE_TABLE_DIR");
+        return std::string(env ? env : "tables");
+    }();
+    return directory;
+}
+
+bool verifyOnLoad = false;
+
+} // namespace
+
+PruningTable::PruningTable(uint64_t size)
+    : entryCount(size), encoding(PACKED4), owned((size + 7) / 8, 0xFFFFFFFF),
+      entries(reinterpret_cast<const uint8_t*>(owned.data())),
+      mapping(nullptr), mappingSize(0), expectedHash(0) {
+}
+
+PruningTable::~PruningTable() {
+    unmap();
+}
+
+PruningTable::PruningTable(PruningTable&& other) noexcept
+    : entryCount(0), encoding(PACKED4), entries(nullptr), mapping(nullptr), mappingSize(0), expectedHash(0) {
+    *this = std::move(other);
+}
+
+PruningTable& PruningTable::operator=(PruningTable&& other) noexcept {
+    if (this == &other) return *this;
+    unmap();
+    entryCount = other.entryCount;
+    encoding = other.encoding;
+    owned = std::move(other.owned);
+    entries = other.mapping ? other.entries : reinterpret_cast<const uint8_t*>(owned.data());
+    mapping = other.mapping;
+    mappingSize = other.mappingSize;
+    expectedHash = other.expectedHash;
+    other.entryCount = 0;
+    other.entries = nullptr;
+    other.mapping = nullptr;
+    other.mappingSize = 0;
+    return *this;
+}
+
+void PruningTable::unmap() {
+    if (mapping) munmap(mapping, mappingSize);
+    mapping = nullptr;
+    mappingSize = 0;
+}
+
+bool PruningTable::save(const std::string& path, const std::string& layout) const {
+    if (layout.size() >= sizeof(FileHeader::layout)) return false;
+
+    size_t slash = path.find_last_of('/');
+    if (slash != std::string::npos) mkdir(path.substr(0, slash).c_str(), 0755);
+
+    uint64_t payloadSize = this->payloadSize();
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FILE_VERSION;
+    header.bitsPerEntry = encoding == MOD3 ? 2 : 4;
+    header.entryCount = entryCount;
+    header.payloadSize = payloadSize;
+    header.payloadHash = fnv1a(entries, payloadSize);
+    std::memcpy(header.layout, layout.data(), layout.size());
+
+    std::vector<char> page(HEADER_SIZE, 0);
+    std::memcpy(page.data(), &header, sizeof(header));
+
+    // Write under a temporary name and rename, so readers never map a partial file.
+    std::string temporary = path + ".tmp" + std::to_string(getpid());
+    FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) return false;
+    bool ok = std::fwrite(page.data(), 1, page.size(), file) == page.size()
+           && std::fwrite(entries, 1, payloadSize, file) == payloadSize;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool PruningTable::load(const std::string& path, const std::string& layout, uint64_t expectedSize,
+                        Encoding expectedEncoding) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    FileHeader header;
+    struct stat info;
+    uint64_t payloadSize = expectedEncoding == MOD3 ? (expectedSize + 3) / 4 : (expectedSize + 1) / 2;
+    bool ok = pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header)
+           && std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+           && header.version == FILE_VERSION
+           && header.bitsPerEntry == (expectedEncoding == MOD3 ? 2u : 4u)
+           && header.entryCount == expectedSize
+           && header.payloadSize == payloadSize
+           && layout.size() < sizeof(header.layout)
+           && std::strncmp(header.layout, layout.c_str(), sizeof(header.layout)) == 0
+           && fstat(fd, &info) == 0
+           && (uint64_t)info.st_size >= HEADER_SIZE + payloadSize;
+
+    void* address = MAP_FAILED;
+    size_t length = HEADER_SIZE + payloadSize;
+    if (ok) address = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) return false;
+
+    const uint8_t* payload = static_cast<const uint8_t*>(address) + HEADER_SIZE;
+    if (verifyOnLoad && fnv1a(payload, payloadSize) != header.payloadHash) {
+        std::fprintf(stderr, "%s: payload hash mismatch, rebuilding\n", path.c_str());
+        munmap(address, length);
+        return false;
+    }
+
+    // Lookups are scattered, so readahead would only pull in pages nobody asked for.
+    madvise(address, length, MADV_RANDOM);
+
+    unmap();
+    owned.clear();
+    owned.shrink_to_fit();
+    mapping = address;
+    mappingSize = length;
+    entries = payload;
+    entryCount = expectedSize;
+    encoding = expectedEncoding;
+    expectedHash = header.payloadHash;
+    return true;
+}
+
+bool PruningTable::verify() const {
+    if (!mapping) return true;
+    return fnv1a(entries, payloadSize()) == expectedHash;
+}
+
+PruningTable PruningTable::toMod3() const {
+    PruningTable table;
+    table.entryCount = entryCount;
+    table.encoding = MOD3;
+    table.owned.assign((entryCount + 15) / 16, 0xFFFFFFFF);
+    table.entries = reinterpret_cast<const uint8_t*>(table.owned.data());
+    uint8_t* out = reinterpret_cast<uint8_t*>(table.owned.data());
+    for (uint64_t i = 0; i < entryCount; ++i) {
+        int value = get(i);
+        int residue = value == EMPTY ? MOD3_EMPTY : value % 3;
+        int shift = (int)(i & 3) << 1;
+        out[i >> 2] = (uint8_t)((out[i >> 2] & ~(0x03 << shift)) | (residue << shift));
+    }
+    return table;
+}
+
+void PruningTable::setVerify(bool verify) {
+    verifyOnLoad = verify;
+}
+
+void PruningTable::setDirectory(const std::string& directory) {
+    tableDirectory() = directory;
+}
+
+std::string PruningTable::filePath(const std::string& layout) {
+    const std::string& directory = tableDirectory();
+    if (directory.empty()) return "";
+    std::string name = layout;
+    for (char& c : name)
+        if (c == '/' || c == ' ') c = '_';
+    return directory + "/" + name + ".tbl";
+}
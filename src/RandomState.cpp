@@ -0,0 +1,143 @@
+#include "RandomState.h"
+#include "Coordinates.h"
+#include "WorkStealingPool.h"
+
+namespace {
+
+uint64_t splitMix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Decodes `rank` as a Lehmer code into a permutation of N pieces held one per nibble,
+// Fisher-Yates style: digit N - 1 picks the piece for slot N - 1 among the first N, and
+// so on down. Each digit is (rank / D) % n for a constant D, so the divisions are all
+// by constants and independent of each other, and the swaps stay in a register.
+// Returns the permutation parity.
+template <int N, uint32_t D = 1>
+struct Unrank
+{
+    static int apply(uint64_t& pieces, uint32_t rank) {
+        uint32_t j = rank / D % N;
+        uint64_t x = ((pieces >> (4 * (N - 1))) ^ (pieces >> (4 * j))) & 0xF;
+        pieces ^= x << (4 * (N - 1)) | x << (4 * j);
+        return (int)(j != N - 1) ^ Unrank<N - 1, D * N>::apply(pieces, rank);
+    }
+};
+
+template <uint32_t D>
+struct Unrank<1, D>
+{
+    static int apply(uint64_t&, uint32_t) { return 0; }
+};
+
+} // namespace
+
+RandomStream::RandomStream(uint64_t seed, uint64_t stream) {
+    // Seed and stream are mixed separately so nearby pairs give unrelated states.
+    uint64_t x = seed;
+    uint64_t mixed = splitMix64(x);
+    x = mixed ^ (stream * 0xd1b54a32d192ed03ULL);
+    for (uint64_t& word : s) word = splitMix64(x);
+}
+
+uint64_t RandomStream::next() {
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+uint64_t RandomStream::below64(uint64_t bound) {
+    // Lemire's multiply-and-reject on the full 64 bits.
+    unsigned __int128 m = (unsigned __int128)next() * bound;
+    uint64_t low = (uint64_t)m;
+    if (low < bound) {
+        uint64_t threshold = (0 - bound) % bound;
+        while (low < threshold) {
+            m = (unsigned __int128)next() * bound;
+            low = (uint64_t)m;
+        }
+    }
+    return (uint64_t)(m >> 64);
+}
+
+uint32_t RandomStream::below(uint32_t bound) {
+    // Lemire's multiply-and-reject on the high 32 bits.
+    uint64_t m = (next() >> 32) * bound;
+    uint32_t low = (uint32_t)m;
+    if (low < bound) {
+        uint32_t threshold = (0u - bound) % bound;
+        while (low < threshold) {
+            m = (next() >> 32) * bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+RandomStream RandomStream::split() {
+    return RandomStream(next(), next());
+}
+
+CubeState randomState(RandomStream& rng) {
+    // One draw for the corner permutation and twist, one for the edge permutation and
+    // flip, split into digits by constant divisions.
+    const uint64_t N_EDGE_PERM = 479001600; // 12!
+    uint64_t corners = rng.below64((uint64_t)N_CORNER_PERM * N_TWIST);
+    uint64_t edges = rng.below64(N_EDGE_PERM * N_FLIP);
+    // Both permutation ranks (below 12!) fit in 32 bits, where dividing is cheaper.
+    uint32_t twist = (uint32_t)(corners % N_TWIST), cornerRank = (uint32_t)(corners / N_TWIST);
+    uint32_t flip = (uint32_t)(edges % N_FLIP), edgeRank = (uint32_t)(edges / N_FLIP);
+
+    uint64_t cp = 0x76543210, ep = 0xBA9876543210;
+    int parity = Unrank<8>::apply(cp, cornerRank) ^ Unrank<12>::apply(ep, edgeRank);
+    // Swapping the last two edges pairs the edge permutations of either parity one to one.
+    uint64_t x = ((ep >> 40) ^ (ep >> 44)) & (uint64_t)(0xF * parity);
+    ep ^= x << 40 | x << 44;
+
+    CubeState cube;
+    int twistSum = 0, flipSum = 0;
+    for (int i = 0; i < 7; ++i) {
+        int o = (int)(twist % 3u);
+        twist /= 3;
+        twistSum += o;
+        cube.corners[i] = (uint8_t)(o << 4 | (cp >> (4 * i) & 0xF));
+    }
+    cube.corners[7] = (uint8_t)(((3 - twistSum % 3) % 3) << 4 | (cp >> 28 & 0xF));
+    for (int i = 0; i < 11; ++i) {
+        int o = (int)(flip & 1);
+        flip >>= 1;
+        flipSum += o;
+        cube.edges[i] = (uint8_t)(o << 4 | (ep >> (4 * i) & 0xF));
+    }
+    cube.edges[11] = (uint8_t)((flipSum & 1) << 4 | (ep >> 44 & 0xF));
+    return cube;
+}
+
+void randomStates(CubeState* out, size_t count, uint64_t seed, int threads) {
+    size_t chunks = (count + RANDOM_STATE_CHUNK - 1) / RANDOM_STATE_CHUNK;
+    auto fill = [out, count, seed](size_t chunk) {
+        RandomStream rng(seed, chunk);
+        size_t end = (chunk + 1) * RANDOM_STATE_CHUNK < count ? (chunk + 1) * RANDOM_STATE_CHUNK : count;
+        for (size_t i = chunk * RANDOM_STATE_CHUNK; i < end; ++i) out[i] = randomState(rng);
+    };
+    if (threads == 1 || chunks <= 1) {
+        for (size_t c = 0; c < chunks; ++c) fill(c);
+        return;
+    }
+    WorkStealingPool pool(threads);
+    for (size_t c = 0; c < chunks; ++c) pool.submit([&fill, c] { fill(c); });
+    pool.wait();
+}
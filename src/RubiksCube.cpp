@@ -1,5 +1,6 @@
 #include "RubiksCube.h"
 #include "CubePiece.h"
+#include "CubieGeometry.h"
 #include <string>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -13,15 +14,23 @@ RubiksCube::RubiksCube() {
         }
     }
 
+    mergeMoves = true;
+    instantMode = false;
+    playbackSpeed = 1.0f;
+
     isAnimating = false;
     currentAnimationAngleRad = 0.0f;
-    frameAddedAngle = 0.0f;
     targetAnimationAngleRad = glm::radians(90.0f);
     animationSpeedRad = glm::radians(180.0f); 
     animationWorldAxis = glm::vec3(0.0f);
     animatingLayerIndex = -1;
     animatingFacePlane = ' ';
     animationIsClockwise = true;
+    animatingMove = -1;
+
+    instanceVAO = 0;
+    instanceVBO = 0;
+    instancesDirty = true;
 }
 
 RubiksCube::~RubiksCube() {
@@ -36,140 +45,225 @@ void RubiksCube::setupMesh() {
         }
     }
 
+    glGenVertexArrays(1, &instanceVAO);
+    glGenBuffers(1, &instanceVBO);
+    glBindVertexArray(instanceVAO);
+    CubePiece::bindMeshAttributes();
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(instanceModels), nullptr, GL_DYNAMIC_DRAW);
+    CubePiece::bindInstanceAttributes(instanceVBO);
+    glBindVertexArray(0);
+    instancesDirty = true;
 }
 
-void RubiksCube::draw(Shader& shader) {
+void RubiksCube::cleanupMesh() {
+    if (instanceVAO == 0) return;
+    glDeleteVertexArrays(1, &instanceVAO);
+    glDeleteBuffers(1, &instanceVBO);
+    instanceVAO = 0;
+    instanceVBO = 0;
+}
+
+bool RubiksCube::inAnimatingLayer(int cell) const {
+    if (!isAnimating) return false;
+    int i = cell / 9, j = cell / 3 % 3, k = cell % 3;
+    return (animatingFacePlane == 'X' && i == animatingLayerIndex)
+        || (animatingFacePlane == 'Y' && j == animatingLayerIndex)
+        || (animatingFacePlane == 'Z' && k == animatingLayerIndex);
+}
+
+glm::mat4 RubiksCube::pieceModel(int cell) const {
     float pieceSize = 1.0f; 
     float spacing = 0.01f;
     float totalSize = pieceSize + spacing;
 
+    int i = cell / 9, j = cell / 3 % 3, k = cell % 3;
+    glm::vec3 position((i - 1) * totalSize, (j - 1) * totalSize, (k - 1) * totalSize);
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), position) * cubePieces[i][j][k].get_model();
 
-    for (int i = 0; i < 3; ++i) { // X-axis
-        for (int j = 0; j < 3; ++j) { // Y-axis
-            for (int k = 0; k < 3; ++k) { // Z-axis
-                // Calculate the position of the current piece
-                float xPos = (i - 1) * totalSize;
-                float yPos = (j - 1) * totalSize;
-                float zPos = (k - 1) * totalSize;
-
-                glm::mat4 pieceModel = cubePieces[i][j][k].get_model();
-                glm::mat4 basePieceModel = glm::translate(glm::mat4(1.0f), glm::vec3(xPos, yPos, zPos)) * pieceModel;
-                glm::mat4 finalModel = basePieceModel;
+    if (inAnimatingLayer(cell)) {
+        float visualAngle = animationIsClockwise ? currentAnimationAngleRad : -currentAnimationAngleRad;
+        model = glm::rotate(glm::mat4(1.0f), visualAngle, animationWorldAxis) * model;
+    }
+    return model;
+}
 
-                if (isAnimating) {
-                    bool pieceIsInAnimatingLayer = false;
-                    if (animatingFacePlane == 'X' && i == animatingLayerIndex) pieceIsInAnimatingLayer = true;
-                    else if (animatingFacePlane == 'Y' && j == animatingLayerIndex) pieceIsInAnimatingLayer = true;
-                    else if (animatingFacePlane == 'Z' && k == animatingLayerIndex) pieceIsInAnimatingLayer = true;
+void RubiksCube::draw(Shader& shader) {
+    if (instancesDirty) {
+        // Pieces outside the animating layer first, so the layer is one contiguous range.
+        int n = 0;
+        for (int pass = 0; pass < 2; ++pass)
+            for (int cell = 0; cell < N_PIECES; ++cell)
+                if (inAnimatingLayer(cell) == (pass == 1)) instanceCell[n++] = cell;
+        for (int n = 0; n < N_PIECES; ++n) instanceModels[n] = pieceModel(instanceCell[n]);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(instanceModels), instanceModels);
+        instancesDirty = false;
+    } else if (isAnimating) {
+        const int first = N_PIECES - LAYER_PIECES;
+        for (int n = first; n < N_PIECES; ++n) instanceModels[n] = pieceModel(instanceCell[n]);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::mat4), LAYER_PIECES * sizeof(glm::mat4),
+                        &instanceModels[first]);
+    }
 
-                    if (pieceIsInAnimatingLayer) {
-                        float visualAngle = animationIsClockwise ? currentAnimationAngleRad : -currentAnimationAngleRad;
+    shader.use();
+    glBindVertexArray(instanceVAO);
+    CubePiece::drawInstanced(N_PIECES);
+    glBindVertexArray(0);
+}
 
-                        glm::mat4 animationRotation = glm::rotate(glm::mat4(1.0f), visualAngle, animationWorldAxis);
-                        finalModel = animationRotation * basePieceModel;
-                    }
-                }
 
-                shader.setMat4("model", finalModel);
-                cubePieces[i][j][k].draw(shader);
+void RubiksCube::syncPieces() {
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            for (int k = 0; k < 3; ++k) {
+                cubePieces[i][j][k].orientation = cubieRotation(state, i, j, k);
             }
         }
     }
 }
 
+const CubeState& RubiksCube::getState() const {
+    return state;
+}
 
-void rotate3x3Matrix(std::vector<std::vector<CubePiece>>& matrix, bool clockwise) {
+void RubiksCube::turn(std::string moveName, bool clockwise){
+    int move = parseMove(moveName);
+    if (move < 0 || movePower(move) != 1) return; // Invalid move name
 
-    std::vector<std::vector<CubePiece>> original = matrix; // Create a copy of the original matrix
-    
-    if (clockwise) {
-        for (int i = 0; i < 3; ++i) {
-            for (int j = 0; j < 3; ++j) {
-                matrix[i][j] = original[2 - j][i];
-            }
-        }
-    } else {
-        for (int i = 0; i < 3; ++i) {
-            for (int j = 0; j < 3; ++j) {
-                matrix[i][j] = original[j][2 - i];
-            }
-        }
-    }
+    // "clockwise" follows the key bindings: Shift sends true and gives the inverse turn.
+    queueMove(makeMove(moveFace(move), clockwise ? 3 : 1));
 }
 
+void RubiksCube::queueMove(int move) {
+    moveQueue.push(move);
+}
 
+void RubiksCube::queueMoves(const std::vector<int>& moves) {
+    moveQueue.push(moves);
+}
 
-void RubiksCube::turn(std::string moveName, bool clockwise){
-    if (isAnimating) return; // Don't start a new turn if one is in progress
+void RubiksCube::queueAlgorithm(const Algorithm& algorithm) {
+    moveQueue.push(algorithm.moves());
+}
+
+bool RubiksCube::queueAlgorithm(const std::string& notation) {
+    Algorithm algorithm;
+    if (!Algorithm::parse(notation, algorithm)) return false;
+    queueAlgorithm(algorithm);
+    return true;
+}
+
+void RubiksCube::setMergeMoves(bool merge) {
+    mergeMoves = merge;
+}
+
+void RubiksCube::setInstantMode(bool instant) {
+    instantMode = instant;
+}
+
+void RubiksCube::setPlaybackSpeed(float speed) {
+    playbackSpeed = speed > 0.0f ? speed : 0.0f;
+}
+
+float RubiksCube::getPlaybackSpeed() const {
+    return playbackSpeed;
+}
+
+bool RubiksCube::getInstantMode() const {
+    return instantMode;
+}
+
+CubeState RubiksCube::getTargetState() {
+    takeQueuedMoves();
+    CubeState target = state;
+    if (isAnimating) target.apply(animatingMove);
+    for (int move : pendingMoves) target.apply(move);
+    return target;
+}
+
+bool RubiksCube::isIdle() {
+    takeQueuedMoves();
+    return !isAnimating && pendingMoves.empty();
+}
 
+void RubiksCube::takeQueuedMoves() {
+    incomingMoves.clear();
+    moveQueue.popAll(incomingMoves);
+    bool merge = mergeMoves;
+    for (int move : incomingMoves) {
+        // The move being animated is already committed, so only waiting moves merge.
+        if (merge && !pendingMoves.empty() && moveFace(pendingMoves.back()) == moveFace(move)) {
+            int power = (movePower(pendingMoves.back()) + movePower(move)) % 4;
+            pendingMoves.pop_back();
+            if (power != 0) pendingMoves.push_back(makeMove(moveFace(move), power));
+        } else {
+            pendingMoves.push_back(move);
+        }
+    }
+}
+
+void RubiksCube::startAnimation(int move) {
+    // Layer and world axis of each face in U R F D L B order
+    static const char planes[6] = {'Y', 'X', 'Z', 'Y', 'X', 'Z'};
+    static const int layers[6] = {2, 2, 2, 0, 0, 0};
+    static const glm::vec3 axes[6] = {
+        glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
+        glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+    };
+    int face = moveFace(move);
     isAnimating = true;
     currentAnimationAngleRad = 0.0f;
-    animationIsClockwise = clockwise;
-
-    if (moveName == "R") {
-        animatingFacePlane = 'X'; animatingLayerIndex = 2; animationWorldAxis = glm::vec3(1.0f, 0.0f, 0.0f);
-    } else if (moveName == "L") {
-        animatingFacePlane = 'X'; animatingLayerIndex = 0; animationWorldAxis = glm::vec3(-1.0f, 0.0f, 0.0f);
-    } else if (moveName == "U") {
-        animatingFacePlane = 'Y'; animatingLayerIndex = 2; animationWorldAxis = glm::vec3(0.0f, 1.0f, 0.0f);
-    } else if (moveName == "D") {
-        animatingFacePlane = 'Y'; animatingLayerIndex = 0; animationWorldAxis = glm::vec3(0.0f, -1.0f, 0.0f);
-    } else if (moveName == "F") {
-        animatingFacePlane = 'Z'; animatingLayerIndex = 2; animationWorldAxis = glm::vec3(0.0f, 0.0f, 1.0f);
-    } else if (moveName == "B") {
-        animatingFacePlane = 'Z'; animatingLayerIndex = 0; animationWorldAxis = glm::vec3(0.0f, 0.0f, -1.0f);
-    } else {
-        isAnimating = false; // Invalid move name
-        return;
-    }
+    animatingMove = move;
+    animatingFacePlane = planes[face];
+    animatingLayerIndex = layers[face];
+    animationWorldAxis = axes[face];
+    // A clockwise quarter turn is negative around the outward axis; half turns go the same way.
+    animationIsClockwise = movePower(move) == 3;
+    targetAnimationAngleRad = glm::radians(movePower(move) == 2 ? 180.0f : 90.0f);
+    instancesDirty = true; // Regroup the instances around the new layer
 }
 
 void RubiksCube::update(float deltaTime) {
-    if (!isAnimating) return;
-
-    currentAnimationAngleRad += animationSpeedRad * deltaTime;
-    frameAddedAngle = animationSpeedRad * deltaTime;
-
-
-    if (currentAnimationAngleRad >= targetAnimationAngleRad) {
-        currentAnimationAngleRad = 0.0f; // Reset for next animation
-        isAnimating = false;
-
-        // --- Perform logical state update ---
-        // 1. Update internal orientation of each piece in the turned layer
-        float logicalAngleRad = animationIsClockwise ? targetAnimationAngleRad : -targetAnimationAngleRad;
-        
-        for (int p1 = 0; p1 < 3; ++p1) {
-            for (int p2 = 0; p2 < 3; ++p2) {
-                CubePiece* piece_ptr = nullptr;
-                if (animatingFacePlane == 'X') piece_ptr = &cubePieces[animatingLayerIndex][p1][p2];
-                else if (animatingFacePlane == 'Y') piece_ptr = &cubePieces[p1][animatingLayerIndex][p2];
-                else if (animatingFacePlane == 'Z') piece_ptr = &cubePieces[p1][p2][animatingLayerIndex];
-
-                if (piece_ptr) {
-                    glm::quat turnQuat = glm::angleAxis(logicalAngleRad, animationWorldAxis);
-                    piece_ptr->update_orientation(turnQuat);
-                }
+    takeQueuedMoves();
+
+    bool changed = false;
+    if (instantMode) {
+        // Finish the current turn and everything waiting, in one step.
+        if (isAnimating) {
+            state.apply(animatingMove);
+            isAnimating = false;
+            changed = true;
+        }
+        for (int move : pendingMoves) state.apply(move);
+        changed = changed || !pendingMoves.empty();
+        pendingMoves.clear();
+    } else {
+        // Turns completed within this frame are applied without being drawn, so fast
+        // playback is not limited to one turn per frame.
+        float remaining = animationSpeedRad * playbackSpeed * deltaTime;
+        while (remaining > 0.0f) {
+            if (!isAnimating) {
+                if (pendingMoves.empty()) break;
+                startAnimation(pendingMoves.front());
+                pendingMoves.pop_front();
             }
+            float needed = targetAnimationAngleRad - currentAnimationAngleRad;
+            if (remaining < needed) {
+                currentAnimationAngleRad += remaining;
+                break;
+            }
+            remaining -= needed;
+            currentAnimationAngleRad = 0.0f;
+            isAnimating = false;
+            state.apply(animatingMove);
+            changed = true;
         }
+    }
 
-        std::vector<std::vector<CubePiece>> slice(3, std::vector<CubePiece>(3));
-        if (animatingFacePlane == 'X') {
-            bool direction = (animatingLayerIndex==0)?animationIsClockwise:!animationIsClockwise;
-            for (int r = 0; r < 3; ++r) for (int c = 0; c < 3; ++c) slice[r][c] = cubePieces[animatingLayerIndex][r][c];
-            rotate3x3Matrix(slice, direction);
-            for (int r = 0; r < 3; ++r) for (int c = 0; c < 3; ++c) cubePieces[animatingLayerIndex][r][c] = slice[r][c];
-        } else if (animatingFacePlane == 'Y') {
-            bool direction = (animatingLayerIndex==0)?!animationIsClockwise:animationIsClockwise;
-            for (int r = 0; r < 3; ++r) for (int c = 0; c < 3; ++c) slice[r][c] = cubePieces[r][animatingLayerIndex][c]; // Correct indexing for Y-slice
-            rotate3x3Matrix(slice, direction);
-            for (int r = 0; r < 3; ++r) for (int c = 0; c < 3; ++c) cubePieces[r][animatingLayerIndex][c] = slice[r][c];
-        } else if (animatingFacePlane == 'Z') {
-            bool direction = (animatingLayerIndex==0)?animationIsClockwise:!animationIsClockwise;
-            for (int r = 0; r < 3; ++r) for (int c = 0; c < 3; ++c) slice[r][c] = cubePieces[r][c][animatingLayerIndex]; // Correct indexing for Z-slice
-            rotate3x3Matrix(slice, direction);
-            for (int r = 0; r < 3; ++r) for (int c = 0; c < 3; ++c) cubePieces[r][c][animatingLayerIndex] = slice[r][c];
-        }
-        
-    } 
-}
\ No newline at end of file
+    if (changed) {
+        syncPieces();
+        instancesDirty = true;
+    }
+}
@@ -0,0 +1,139 @@
+#include "SolutionCache.h"
+#include "Symmetry.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// splitmix64 finalizer over the 20 state bytes.
+uint64_t hashState(const CubeState& cube) {
+    uint64_t words[3] = {0, 0, 0};
+    std::memcpy(words, cube.corners, sizeof(cube.corners));
+    std::memcpy(reinterpret_cast<char*>(words) + 8, cube.edges, sizeof(cube.edges));
+    uint64_t h = 0;
+    for (uint64_t w : words) {
+        h += w + 0x9e3779b97f4a7c15ULL;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+bool less(const CubeState& a, const CubeState& b) {
+    int c = std::memcmp(a.corners, b.corners, sizeof(a.corners));
+    return c != 0 ? c < 0 : std::memcmp(a.edges, b.edges, sizeof(a.edges)) < 0;
+}
+
+} // namespace
+
+SolutionCache::SolutionCache(size_t capacity)
+    : shardCapacity((capacity + N_SHARDS - 1) / N_SHARDS), shards(new Shard[N_SHARDS]) {
+}
+
+SolutionCache::Canonical SolutionCache::canonical(const CubeState& cube) {
+    Canonical best;
+    best.state = cube;
+    best.sym = 0;
+    best.inverted = false;
+    CubeState views[2] = {cube, cube.inverse()};
+    for (int inverted = 0; inverted < 2; ++inverted) {
+        for (int s = 0; s < N_SYM; ++s) {
+            CubeState c = conjugate(views[inverted], s);
+            if (less(c, best.state)) {
+                best.state = c;
+                best.sym = s;
+                best.inverted = inverted != 0;
+            }
+        }
+    }
+    best.hash = hashState(best.state);
+    return best;
+}
+
+bool SolutionCache::lookup(const CubeState& cube, std::vector<int>& solution) {
+    if (shardCapacity == 0) return false;
+    Canonical key = canonical(cube);
+    Shard& shard = shardOf(key.hash);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key.hash);
+        if (it == shard.index.end() || it->second->second.state != key.state) {
+            ++shard.misses;
+            return false;
+        }
+        ++shard.hits;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        solution = it->second->second.solution;
+    }
+
+    // The entry solves S * view * S^-1, so S^-1 * move * S for each of its moves solves
+    // the view; when the view is the inverse, the reversed inverse sequence solves cube.
+    const SymmetryTables& sym = symmetryTables();
+    int back = sym.inverse[key.sym];
+    for (int& m : solution) m = sym.conjugateMove[back][m];
+    if (key.inverted) {
+        std::reverse(solution.begin(), solution.end());
+        for (int& m : solution) m = inverseMove(m);
+    }
+    return true;
+}
+
+void SolutionCache::store(const CubeState& cube, const std::vector<int>& solution) {
+    if (shardCapacity == 0) return;
+    Canonical key = canonical(cube);
+
+    // Translate into a solution of the representative: the reverse of lookup().
+    std::vector<int> moves = solution;
+    if (key.inverted) {
+        std::reverse(moves.begin(), moves.end());
+        for (int& m : moves) m = inverseMove(m);
+    }
+    const SymmetryTables& sym = symmetryTables();
+    for (int& m : moves) m = sym.conjugateMove[key.sym][m];
+
+    Shard& shard = shardOf(key.hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key.hash);
+    if (it != shard.index.end()) {
+        Entry& entry = it->second->second;
+        if (entry.state == key.state && entry.solution.size() <= moves.size()) return;
+        entry.state = key.state;
+        entry.solution = std::move(moves);
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+    if (shard.entries.size() >= shardCapacity) {
+        shard.index.erase(shard.entries.back().first);
+        shard.entries.pop_back();
+    }
+    shard.entries.emplace_front(key.hash, Entry{key.state, std::move(moves)});
+    shard.index[key.hash] = shard.entries.begin();
+}
+
+size_t SolutionCache::size() const {
+    size_t total = 0;
+    for (int i = 0; i < N_SHARDS; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        total += shards[i].entries.size();
+    }
+    return total;
+}
+
+uint64_t SolutionCache::hits() const {
+    uint64_t total = 0;
+    for (int i = 0; i < N_SHARDS; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        total += shards[i].hits;
+    }
+    return total;
+}
+
+uint64_t SolutionCache::misses() const {
+    uint64_t total = 0;
+    for (int i = 0; i < N_SHARDS; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        total += shards[i].misses;
+    }
+    return total;
+}
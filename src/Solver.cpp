@@ -0,0 +1,11 @@
+#include "Solver.h"
+#include "OptimalSolver.h"
+#include "ThistlethwaiteSolver.h"
+#include "TwoPhaseSolver.h"
+
+std::unique_ptr<Solver> createSolver(const std::string& name) {
+    if (name == "two-phase") return std::unique_ptr<Solver>(new TwoPhaseSolver);
+    if (name == "optimal") return std::unique_ptr<Solver>(new OptimalSolver);
+    if (name == "thistlethwaite") return std::unique_ptr<Solver>(new ThistlethwaiteSolver);
+    return nullptr;
+}
@@ -0,0 +1,189 @@
+#include "Symmetry.h"
+#include <cstring>
+
+namespace {
+
+// Cubie form that can also hold reflections: a corner orientation of 3..5 means the
+// corner is mirrored, with (orientation - 3) twists.
+struct SymCube
+{
+    uint8_t cp[8], co[8], ep[12], eo[12];
+};
+
+SymCube fromState(const CubeState& cube) {
+    SymCube s;
+    for (int i = 0; i < 8; ++i) {
+        s.cp[i] = (uint8_t)cube.cornerPiece(i);
+        s.co[i] = (uint8_t)cube.cornerOrientation(i);
+    }
+    for (int i = 0; i < 12; ++i) {
+        s.ep[i] = (uint8_t)cube.edgePiece(i);
+        s.eo[i] = (uint8_t)cube.edgeOrientation(i);
+    }
+    return s;
+}
+
+CubeState toState(const SymCube& s) {
+    CubeState cube;
+    for (int i = 0; i < 8; ++i) cube.corners[i] = (uint8_t)(s.co[i] << 4 | s.cp[i]);
+    for (int i = 0; i < 12; ++i) cube.edges[i] = (uint8_t)(s.eo[i] << 4 | s.ep[i]);
+    return cube;
+}
+
+// a * b with the same meaning as CubeState::multiply. A mirrored corner turns its
+// twists the other way, which decides how the orientations combine.
+SymCube multiply(const SymCube& a, const SymCube& b) {
+    SymCube r;
+    for (int i = 0; i < 8; ++i) {
+        r.cp[i] = a.cp[b.cp[i]];
+        int oa = a.co[b.cp[i]], ob = b.co[i], o;
+        if (oa < 3 && ob < 3) {
+            o = (oa + ob) % 3;
+        } else if (oa < 3) {
+            o = oa + ob;
+            if (o >= 6) o -= 3;
+        } else if (ob < 3) {
+            o = oa - ob;
+            if (o < 3) o += 3;
+        } else {
+            o = oa - ob;
+            if (o < 0) o += 3;
+        }
+        r.co[i] = (uint8_t)o;
+    }
+    for (int i = 0; i < 12; ++i) {
+        r.ep[i] = a.ep[b.ep[i]];
+        r.eo[i] = (uint8_t)(a.eo[b.ep[i]] ^ b.eo[i]);
+    }
+    return r;
+}
+
+bool operator==(const SymCube& a, const SymCube& b) {
+    return std::memcmp(&a, &b, sizeof(SymCube)) == 0;
+}
+
+// The four generators, in Kociemba's slot order.
+const SymCube urf3 = {
+    {0, 4, 5, 1, 3, 7, 6, 2}, {1, 2, 1, 2, 2, 1, 2, 1},
+    {1, 8, 5, 9, 3, 11, 7, 10, 0, 4, 6, 2}, {1, 0, 1, 0, 1, 0, 1, 0, 1, 1, 1, 1}
+};
+const SymCube f2 = {
+    {5, 4, 7, 6, 1, 0, 3, 2}, {0, 0, 0, 0, 0, 0, 0, 0},
+    {6, 5, 4, 7, 2, 1, 0, 3, 9, 8, 11, 10}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+};
+const SymCube u4 = {
+    {3, 0, 1, 2, 7, 4, 5, 6}, {0, 0, 0, 0, 0, 0, 0, 0},
+    {3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10}, {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1}
+};
+const SymCube lr2 = {
+    {1, 0, 3, 2, 5, 4, 7, 6}, {3, 3, 3, 3, 3, 3, 3, 3},
+    {2, 1, 0, 3, 6, 5, 4, 7, 9, 8, 11, 10}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+};
+
+SymCube symCubes[N_SYM];
+int inverseSym[N_SYM];
+
+void buildSymCubes() {
+    SymCube c = fromState(CubeState());
+    int index = 0;
+    for (int a = 0; a < 3; ++a) {
+        for (int b = 0; b < 2; ++b) {
+            for (int d = 0; d < 4; ++d) {
+                for (int e = 0; e < 2; ++e) {
+                    symCubes[index++] = c;
+                    c = multiply(c, lr2);
+                }
+                c = multiply(c, u4);
+            }
+            c = multiply(c, f2);
+        }
+        c = multiply(c, urf3);
+    }
+
+    SymCube identity = fromState(CubeState());
+    for (int s = 0; s < N_SYM; ++s)
+        for (int k = 0; k < N_SYM; ++k)
+            if (multiply(symCubes[s], symCubes[k]) == identity) inverseSym[s] = k;
+}
+
+CubeState conjugateCube(const CubeState& cube, int sym) {
+    return toState(multiply(multiply(symCubes[sym], fromState(cube)), symCubes[inverseSym[sym]]));
+}
+
+// Assigns every raw coordinate below `size` to a class. `conjugated(x, s)` is the raw
+// coordinate of x conjugated by symmetry s. Returns the number of classes.
+template <class Conjugated, class Class, class Sym, class Rep>
+int buildClasses(int size, Conjugated conjugated, Class* classOf, Sym* symOf, Rep* rep, const int* inverse) {
+    const Class unassigned = (Class)~(Class)0;
+    for (int x = 0; x < size; ++x) classOf[x] = unassigned;
+    int classes = 0;
+    for (int x = 0; x < size; ++x) {
+        if (classOf[x] != unassigned) continue;
+        rep[classes] = (Rep)x;
+        for (int s = 0; s < N_SYM_UD; ++s) {
+            int y = conjugated(x, s);
+            if (classOf[y] != unassigned) continue;
+            classOf[y] = (Class)classes;
+            symOf[y] = (Sym)inverse[s];
+        }
+        ++classes;
+    }
+    return classes;
+}
+
+SymmetryTables* buildTables() {
+    buildSymCubes();
+    SymmetryTables* t = new SymmetryTables;
+
+    std::memcpy(t->inverse, inverseSym, sizeof(inverseSym));
+
+    for (int s = 0; s < N_SYM; ++s) {
+        for (int m = 0; m < N_MOVES; ++m) {
+            CubeState moved = conjugateCube(CubeState().applied(m), s);
+            for (int n = 0; n < N_MOVES; ++n)
+                if (moved == CubeState().applied(n)) t->conjugateMove[s][m] = n;
+        }
+    }
+
+    for (int twist = 0; twist < N_TWIST; ++twist) {
+        CubeState cube;
+        setTwist(cube, twist);
+        for (int s = 0; s < N_SYM_UD; ++s) t->twistConjugate[twist][s] = (uint16_t)getTwist(conjugateCube(cube, s));
+    }
+    for (int perm = 0; perm < N_EDGE8_PERM; ++perm) {
+        CubeState cube;
+        setEdge8Perm(cube, perm);
+        for (int s = 0; s < N_SYM_UD; ++s) t->edge8Conjugate[perm][s] = (uint16_t)getEdge8Perm(conjugateCube(cube, s));
+    }
+
+    t->flipSliceClass.resize(N_FLIPSLICE);
+    t->flipSliceSym.resize(N_FLIPSLICE);
+    t->flipSliceRep.resize(N_FLIPSLICE_CLASS);
+    buildClasses(N_FLIPSLICE, [](int x, int s) {
+            CubeState cube;
+            setSlice(cube, x % N_SLICE);
+            setFlip(cube, x / N_SLICE);
+            CubeState c = conjugateCube(cube, s);
+            return getFlip(c) * N_SLICE + getSlice(c);
+        },
+        t->flipSliceClass.data(), t->flipSliceSym.data(), t->flipSliceRep.data(), t->inverse);
+    buildClasses(N_CORNER_PERM, [](int x, int s) {
+            CubeState cube;
+            setCornerPerm(cube, x);
+            return getCornerPerm(conjugateCube(cube, s));
+        },
+        t->cornerClass, t->cornerSym, t->cornerRep, t->inverse);
+    return t;
+}
+
+} // namespace
+
+CubeState conjugate(const CubeState& cube, int sym) {
+    symmetryTables(); // Builds the symmetry cubes on first use
+    return conjugateCube(cube, sym);
+}
+
+const SymmetryTables& symmetryTables() {
+    static const SymmetryTables* instance = buildTables();
+    return *instance;
+}
@@ -0,0 +1,322 @@
+#include "ThistlethwaiteSolver.h"
+#include "Algorithm.h"
+#include "Coordinates.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Moves of each phase's group, as indices into the 18 moves.
+const int N_PHASE2_MOVES = 14;
+constexpr int phase2Moves[N_PHASE2_MOVES] = {0, 1, 2, 3, 4, 5, 7, 9, 10, 11, 12, 13, 14, 16}; // All but F F' B B'
+const int N_PHASE3_MOVES = 10;
+constexpr int phase3Moves[N_PHASE3_MOVES] = {0, 1, 2, 9, 10, 11, 4, 13, 7, 16}; // U U2 U' D D2 D' R2 L2 F2 B2
+const int N_PHASE4_MOVES = 6;
+constexpr int phase4Moves[N_PHASE4_MOVES] = {1, 4, 7, 10, 13, 16}; // U2 R2 F2 D2 L2 B2
+
+// Phase 3 coordinates. The corner permutations of the half-turn group H fall into 420
+// cosets H * p of the 8! permutations; whether p followed by some moves lands in H only
+// depends on the coset, so phase 3 only needs to know which one the cube is in. The
+// edges only matter through which 4 of the 8 U/D edge slots hold M-slice edges.
+const int N_HALF_TURN_CORNERS = 96;
+const int N_CORNER_COSET = N_CORNER_PERM / N_HALF_TURN_CORNERS; // 420
+const int N_M_CHOICE = 70;                                      // C(8,4)
+
+// Phase 4 coordinates: the corner permutation within H, and the permutation of each
+// slice's edges within the slice. All of H is even, so the S-slice parity follows
+// from the other two and only half its permutations are indexed.
+const int N_SLICE_EDGES = 24; // 4!
+const int N_PHASE4 = N_HALF_TURN_CORNERS * N_SLICE_EDGES * N_SLICE_EDGES * N_SLICE_EDGES / 2;
+
+// Edge slots of each slice, in the order their permutation is ranked.
+const int E_SLICE = 0, M_SLICE = 1, S_SLICE = 2;
+constexpr int sliceSlots[3][4] = {{8, 9, 10, 11}, {1, 3, 5, 7}, {0, 2, 4, 6}};
+
+const uint8_t UNREACHED = 0xFF;
+
+struct ThistlethwaiteTables {
+    // Corner permutation -> its index in H (UNREACHED if not in H), and its coset.
+    uint8_t halfTurnCorner[N_CORNER_PERM];
+    uint16_t cornerCoset[N_CORNER_PERM];
+
+    uint16_t cosetMove[N_CORNER_COSET][N_PHASE3_MOVES];
+    uint8_t mChoiceMove[N_M_CHOICE][N_PHASE3_MOVES];
+    uint8_t halfTurnCornerMove[N_HALF_TURN_CORNERS][N_PHASE4_MOVES];
+    uint16_t phase4EdgeMove[N_PHASE4 / N_HALF_TURN_CORNERS][N_PHASE4_MOVES];
+
+    // Exact distances to the next phase's group, one byte per coordinate.
+    std::vector<uint8_t> phase1; // flip
+    std::vector<uint8_t> phase2; // twist * N_SLICE + slice
+    std::vector<uint8_t> phase3; // coset * N_M_CHOICE + M choice
+    std::vector<uint8_t> phase4; // corner in H * 6912 + Phase4::edges(E perm, M perm, S perm)
+};
+
+bool isMSliceEdge(int piece) {
+    return piece < CubeState::FR && (piece & 1); // UF UB DF DB
+}
+
+// Which U/D edge slots hold M-slice edges, ranked like getSlice().
+int getMChoice(const CubeState& cube) {
+    int choice = 0, seen = 0;
+    for (int j = 7; j >= 0; --j) {
+        if (isMSliceEdge(cube.edgePiece(j))) {
+            choice += binomial(7 - j, seen + 1);
+            ++seen;
+        }
+    }
+    return choice;
+}
+
+int getSliceEdgePerm(const CubeState& cube, int slice) {
+    uint8_t perm[4] = {};
+    for (int i = 0; i < 4; ++i)
+        for (int k = 0; k < 4; ++k)
+            if (cube.edgePiece(sliceSlots[slice][i]) == sliceSlots[slice][k]) perm[i] = (uint8_t)k;
+    return rankPermutation(perm, 4);
+}
+
+void setSliceEdgePerm(CubeState& cube, int slice, int rank) {
+    uint8_t perm[4] = {};
+    unrankPermutation(rank, perm, 4);
+    for (int i = 0; i < 4; ++i) cube.edges[sliceSlots[slice][i]] = (uint8_t)sliceSlots[slice][perm[i]];
+}
+
+// Each phase's coordinate is major * MINOR + minor, where a move takes each part to a
+// value that depends on that part alone.
+struct Phase1
+{
+    static const int MAJOR = N_FLIP, MINOR = 1, MOVES = N_MOVES;
+    static constexpr const int* moves = allMoves;
+    int major(int flip, int k) const { return flipMoveTable[flip][k]; }
+    int minor(int, int) const { return 0; }
+};
+
+struct Phase2
+{
+    static const int MAJOR = N_TWIST, MINOR = N_SLICE, MOVES = N_PHASE2_MOVES;
+    static constexpr const int* moves = phase2Moves;
+    int major(int twist, int k) const { return twistMoveTable[twist][phase2Moves[k]]; }
+    int minor(int slice, int k) const { return sliceMoveTable[slice][phase2Moves[k]]; }
+};
+
+struct Phase3
+{
+    static const int MAJOR = N_CORNER_COSET, MINOR = N_M_CHOICE, MOVES = N_PHASE3_MOVES;
+    static constexpr const int* moves = phase3Moves;
+    const ThistlethwaiteTables& t;
+    int major(int coset, int k) const { return t.cosetMove[coset][k]; }
+    int minor(int choice, int k) const { return t.mChoiceMove[choice][k]; }
+};
+
+struct Phase4
+{
+    static const int MAJOR = N_HALF_TURN_CORNERS, MINOR = N_PHASE4 / N_HALF_TURN_CORNERS, MOVES = N_PHASE4_MOVES;
+    static constexpr const int* moves = phase4Moves;
+    const ThistlethwaiteTables& t;
+
+    static int edges(int e, int m, int s) { return (e * N_SLICE_EDGES + m) * (N_SLICE_EDGES / 2) + s / 2; }
+    int major(int corner, int k) const { return t.halfTurnCornerMove[corner][k]; }
+    int minor(int edges, int k) const { return t.phase4EdgeMove[edges][k]; }
+};
+
+// Breadth-first distances from the coordinate (rootMajor, rootMinor), one pass over the
+// table per depth, so that the only memory used is the table itself. A pass goes one
+// major row at a time: it lists the row's entries at the current depth, then moves them
+// all with each move in turn, which keeps the two rows involved in the cache, and it
+// skips the rows with no entry at that depth. As in PruningTable::generate, once the
+// frontier outnumbers the entries still unreached, a pass instead lists those and looks
+// for a neighbour on the frontier; each phase's group is closed under inverses, so the
+// neighbours are also the predecessors.
+template <class Phase>
+std::vector<uint8_t> distances(const Phase& phase, int rootMajor, int rootMinor) {
+    const uint32_t size = (uint32_t)Phase::MAJOR * Phase::MINOR;
+    std::vector<uint8_t> distance(size, UNREACHED);
+    std::vector<uint16_t> listed(Phase::MINOR + 1);
+    std::vector<uint8_t> atDepth(Phase::MAJOR), atNextDepth(Phase::MAJOR); // Rows with entries there
+    std::vector<uint16_t> unreached(Phase::MAJOR, Phase::MINOR);              // Per row
+    distance[(uint32_t)rootMajor * Phase::MINOR + rootMinor] = 0;
+    atNextDepth[rootMajor] = 1;
+    --unreached[rootMajor];
+    uint32_t filled = 1, frontier = 1;
+    for (uint8_t depth = 0; frontier > 0; ++depth) {
+        bool backward = frontier > size - filled;
+        frontier = 0;
+        atDepth.swap(atNextDepth);
+        std::fill(atNextDepth.begin(), atNextDepth.end(), 0);
+        for (int major = 0; major < Phase::MAJOR; ++major) {
+            if (backward ? unreached[major] == 0 : !atDepth[major]) continue;
+            uint8_t* row = &distance[(uint32_t)major * Phase::MINOR];
+            const uint8_t wanted = backward ? UNREACHED : depth;
+            int count = 0;
+            for (int minor = 0; minor < Phase::MINOR; ++minor) { // Without branches, as most entries are skipped
+                listed[count] = (uint16_t)minor;
+                count += row[minor] == wanted;
+            }
+            for (int k = 0; k < Phase::MOVES && count > 0; ++k) {
+                int otherMajor = phase.major(major, k);
+                uint8_t* other = &distance[(uint32_t)otherMajor * Phase::MINOR];
+                if (backward) {
+                    // Entries found to be at depth + 1 leave the list
+                    for (int j = 0; j < count;) {
+                        if (other[phase.minor(listed[j], k)] == depth) {
+                            row[listed[j]] = depth + 1;
+                            ++frontier;
+                            --unreached[major];
+                            atNextDepth[major] = 1;
+                            listed[j] = listed[--count];
+                        } else {
+                            ++j;
+                        }
+                    }
+                } else {
+                    int reached = 0;
+                    for (int j = 0; j < count; ++j) {
+                        uint8_t& next = other[phase.minor(listed[j], k)];
+                        bool fresh = next == UNREACHED;
+                        next = fresh ? depth + 1 : next;
+                        reached += fresh;
+                    }
+                    frontier += reached;
+                    unreached[otherMajor] -= reached;
+                    atNextDepth[otherMajor] |= reached > 0;
+                }
+            }
+        }
+        filled += frontier;
+    }
+    return distance;
+}
+
+ThistlethwaiteTables* buildTables() {
+    ThistlethwaiteTables* t = new ThistlethwaiteTables;
+
+    // H, by closing the solved cube under the half turns
+    std::vector<CubeState> halfTurn(1);
+    std::fill(t->halfTurnCorner, t->halfTurnCorner + N_CORNER_PERM, UNREACHED);
+    t->halfTurnCorner[0] = 0;
+    for (size_t i = 0; i < halfTurn.size(); ++i) {
+        for (int k = 0; k < N_PHASE4_MOVES; ++k) {
+            CubeState next = halfTurn[i].applied(phase4Moves[k]);
+            uint8_t& index = t->halfTurnCorner[getCornerPerm(next)];
+            if (index == UNREACHED) {
+                index = (uint8_t)halfTurn.size();
+                halfTurn.push_back(next);
+            }
+            t->halfTurnCornerMove[i][k] = index;
+        }
+    }
+
+    // The cosets H * p, each with its first permutation as representative
+    uint16_t representative[N_CORNER_COSET];
+    std::fill(t->cornerCoset, t->cornerCoset + N_CORNER_PERM, (uint16_t)0xFFFF);
+    for (int p = 0, coset = 0; p < N_CORNER_PERM; ++p) {
+        if (t->cornerCoset[p] != 0xFFFF) continue;
+        CubeState cube;
+        setCornerPerm(cube, p);
+        for (const CubeState& h : halfTurn) {
+            CubeState member = h;
+            member.multiply(cube);
+            t->cornerCoset[getCornerPerm(member)] = (uint16_t)coset;
+        }
+        representative[coset++] = (uint16_t)p;
+    }
+    for (int c = 0; c < N_CORNER_COSET; ++c) {
+        CubeState cube;
+        setCornerPerm(cube, representative[c]);
+        for (int k = 0; k < N_PHASE3_MOVES; ++k)
+            t->cosetMove[c][k] = t->cornerCoset[getCornerPerm(cube.applied(phase3Moves[k]))];
+    }
+
+    // Every placement of the M-slice edges among the U/D edge slots
+    for (int mask = 0; mask < 256; ++mask) {
+        if (__builtin_popcount(mask) != 4) continue;
+        CubeState cube;
+        for (int j = 0, m = 0, s = 0; j < 8; ++j)
+            cube.edges[j] = (uint8_t)((mask >> j) & 1 ? sliceSlots[M_SLICE][m++] : sliceSlots[S_SLICE][s++]);
+        int choice = getMChoice(cube);
+        for (int k = 0; k < N_PHASE3_MOVES; ++k)
+            t->mChoiceMove[choice][k] = (uint8_t)getMChoice(cube.applied(phase3Moves[k]));
+    }
+
+    // Half turns on each slice's edge permutation, then on the phase 4 edge coordinate
+    uint8_t slicePermMove[3][N_SLICE_EDGES][N_PHASE4_MOVES], parity[N_SLICE_EDGES];
+    for (int slice = 0; slice < 3; ++slice) {
+        for (int p = 0; p < N_SLICE_EDGES; ++p) {
+            CubeState cube;
+            setSliceEdgePerm(cube, slice, p);
+            for (int k = 0; k < N_PHASE4_MOVES; ++k)
+                slicePermMove[slice][p][k] = (uint8_t)getSliceEdgePerm(cube.applied(phase4Moves[k]), slice);
+            parity[p] = (uint8_t)cube.edgeParity();
+        }
+    }
+    for (int e = 0; e < N_SLICE_EDGES; ++e) {
+        for (int m = 0; m < N_SLICE_EDGES; ++m) {
+            for (int s = 0; s < N_SLICE_EDGES; ++s) {
+                if ((parity[s] ^ parity[e] ^ parity[m]) != 0) continue; // All of H is even
+                for (int k = 0; k < N_PHASE4_MOVES; ++k)
+                    t->phase4EdgeMove[Phase4::edges(e, m, s)][k] = (uint16_t)Phase4::edges(
+                        slicePermMove[E_SLICE][e][k], slicePermMove[M_SLICE][m][k], slicePermMove[S_SLICE][s][k]);
+            }
+        }
+    }
+
+    t->phase1 = distances(Phase1(), 0, 0);
+    t->phase2 = distances(Phase2(), 0, 0);
+    t->phase3 = distances(Phase3{*t}, t->cornerCoset[0], getMChoice(CubeState()));
+    t->phase4 = distances(Phase4{*t}, 0, 0);
+    return t;
+}
+
+const ThistlethwaiteTables& tables() {
+    static const ThistlethwaiteTables* instance = buildTables();
+    return *instance;
+}
+
+// Appends the moves that take (major, minor) down `distance` to 0, applying them to `cube`.
+template <class Phase>
+void descend(const Phase& phase, const std::vector<uint8_t>& distance, int major, int minor, CubeState& cube,
+             std::vector<int>& solution) {
+    for (int d = distance[(uint32_t)major * Phase::MINOR + minor]; d > 0; --d) {
+        for (int k = 0; k < Phase::MOVES; ++k) {
+            int nextMajor = phase.major(major, k), nextMinor = phase.minor(minor, k);
+            if (distance[(uint32_t)nextMajor * Phase::MINOR + nextMinor] == d - 1) {
+                major = nextMajor;
+                minor = nextMinor;
+                cube.apply(Phase::moves[k]);
+                solution.push_back(Phase::moves[k]);
+                break;
+            }
+        }
+    }
+}
+
+} // namespace
+
+ThistlethwaiteSolver::ThistlethwaiteSolver() {
+    tables();
+}
+
+bool ThistlethwaiteSolver::solve(const CubeState& cube, std::vector<int>& solution) {
+    solution.clear();
+    if (!cube.isValid()) return false;
+    const ThistlethwaiteTables& t = tables();
+    CubeState c = cube;
+    std::vector<int> moves;
+
+    descend(Phase1(), t.phase1, getFlip(c), 0, c, moves);
+    descend(Phase2(), t.phase2, getTwist(c), getSlice(c), c, moves);
+    descend(Phase3{t}, t.phase3, t.cornerCoset[getCornerPerm(c)], getMChoice(c), c, moves);
+    descend(Phase4{t}, t.phase4, t.halfTurnCorner[getCornerPerm(c)],
+            Phase4::edges(getSliceEdgePerm(c, E_SLICE), getSliceEdgePerm(c, M_SLICE), getSliceEdgePerm(c, S_SLICE)),
+            c, moves);
+    if (!c.isSolved()) return false;
+
+    // Merges the moves on either side of each phase boundary
+    solution = Algorithm(moves).moves();
+    return true;
+}
+
+size_t ThistlethwaiteSolver::tableBytes() {
+    const ThistlethwaiteTables& t = tables();
+    return sizeof(t) + t.phase1.size() + t.phase2.size() + t.phase3.size() + t.phase4.size();
+}
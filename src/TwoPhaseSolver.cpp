@@ -0,0 +1,237 @@
+#include "TwoPhaseSolver.h"
+#include "Coordinates.h"
+#include "PackedCube.h"
+#include "PruningTable.h"
+#include "Symmetry.h"
+
+namespace {
+
+// Moves that keep the cube in the phase 2 subgroup.
+const int N_PHASE2_MOVES = 10;
+constexpr int phase2Moves[N_PHASE2_MOVES] = {0, 1, 2, 9, 10, 11, 4, 13, 7, 16}; // U U2 U' D D2 D' R2 L2 F2 B2
+
+// Phase 1 moves the orientation and slice coordinates with the compile-time tables of
+// Coordinates.h; this one is small enough to build here the same way.
+constexpr MoveTable<uint8_t, N_SLICE_PERM, N_PHASE2_MOVES> slicePermMove =
+    makeMoveTable<uint8_t, N_SLICE_PERM>(phase2Moves, setSlicePerm, getSlicePerm);
+
+// The permutation tables are too large to be worth the compiler's time.
+struct TwoPhaseTables {
+    uint16_t cornerPermMove[N_CORNER_PERM][N_PHASE2_MOVES];
+    uint16_t edge8PermMove[N_EDGE8_PERM][N_PHASE2_MOVES];
+
+    // Symmetry-reduced tables: the first coordinate is a class under the UD symmetries
+    // and the second is conjugated by the symmetry that leads to its representative.
+    PruningTable flipSliceTwist;  // Phase 1: flipslice class * N_TWIST + twist, exact
+    PruningTable cornerEdge8;     // Phase 2: corner class * N_EDGE8_PERM + edge8Perm
+    PruningTable cornerSlicePerm; // Phase 2: cornerPerm * N_SLICE_PERM + slicePerm
+};
+
+TwoPhaseTables* buildTables() {
+    TwoPhaseTables* t = new TwoPhaseTables;
+    buildMoveTable(t->cornerPermMove, N_CORNER_PERM, phase2Moves, setCornerPerm, getCornerPerm);
+    buildMoveTable(t->edge8PermMove, N_EDGE8_PERM, phase2Moves, setEdge8Perm, getEdge8Perm);
+
+    const SymmetryTables& sym = symmetryTables();
+    t->flipSliceTwist.loadOrGenerate("twophase/flipslice-twist sym v1", (uint64_t)N_FLIPSLICE_CLASS * N_TWIST, 0,
+        [t, &sym](uint64_t i, uint64_t* out) {
+            int flipSlice = (int)sym.flipSliceRep[i / N_TWIST], twist = (int)(i % N_TWIST);
+            int flip = flipSlice / N_SLICE, slice = flipSlice % N_SLICE;
+            for (int m = 0; m < N_MOVES; ++m) {
+                int moved = flipMoveTable[flip][m] * N_SLICE + sliceMoveTable[slice][m];
+                out[m] = (uint64_t)sym.flipSliceClass[moved] * N_TWIST
+                       + sym.twistConjugate[twistMoveTable[twist][m]][sym.flipSliceSym[moved]];
+            }
+            return N_MOVES;
+        });
+    t->cornerEdge8.loadOrGenerate("twophase/corner-edge8 sym v1", (uint64_t)N_CORNER_CLASS * N_EDGE8_PERM, 0,
+        [t, &sym](uint64_t i, uint64_t* out) {
+            int corner = sym.cornerRep[i / N_EDGE8_PERM], edge = (int)(i % N_EDGE8_PERM);
+            for (int m = 0; m < N_PHASE2_MOVES; ++m) {
+                int moved = t->cornerPermMove[corner][m];
+                out[m] = (uint64_t)sym.cornerClass[moved] * N_EDGE8_PERM
+                       + sym.edge8Conjugate[t->edge8PermMove[edge][m]][sym.cornerSym[moved]];
+            }
+            return N_PHASE2_MOVES;
+        });
+    t->cornerSlicePerm.loadOrGenerate("twophase/corner-sliceperm v1", (uint64_t)N_CORNER_PERM * N_SLICE_PERM, 0,
+        [t](uint64_t i, uint64_t* out) {
+            int corner = (int)(i / N_SLICE_PERM), slice = (int)(i % N_SLICE_PERM);
+            for (int m = 0; m < N_PHASE2_MOVES; ++m)
+                out[m] = (uint64_t)t->cornerPermMove[corner][m] * N_SLICE_PERM + slicePermMove[slice][m];
+            return N_PHASE2_MOVES;
+        });
+    return t;
+}
+
+const TwoPhaseTables& tables() {
+    static const TwoPhaseTables* instance = buildTables();
+    return *instance;
+}
+
+// Skips turning the same face twice in a row, and orders commuting opposite faces.
+bool redundantAfter(int face, int previousFace) {
+    return face == previousFace || face == previousFace - 3;
+}
+
+int phase1Distance(const TwoPhaseTables& t, int twist, int flip, int slice) {
+    const SymmetryTables& sym = symmetryTables();
+    int flipSlice = flip * N_SLICE + slice;
+    return t.flipSliceTwist.get((uint64_t)sym.flipSliceClass[flipSlice] * N_TWIST
+                                + sym.twistConjugate[twist][sym.flipSliceSym[flipSlice]]);
+}
+
+int phase2Distance(const TwoPhaseTables& t, int cornerPerm, int edge8Perm, int slicePerm) {
+    const SymmetryTables& sym = symmetryTables();
+    int a = t.cornerSlicePerm.get((uint64_t)cornerPerm * N_SLICE_PERM + slicePerm);
+    int b = t.cornerEdge8.get((uint64_t)sym.cornerClass[cornerPerm] * N_EDGE8_PERM
+                              + sym.edge8Conjugate[edge8Perm][sym.cornerSym[cornerPerm]]);
+    return a > b ? a : b;
+}
+
+} // namespace
+
+TwoPhaseSolver::TwoPhaseSolver()
+    : maxLength(0), solutionLength(0), found(false), anytime(false), stopped(false), nodes(0),
+      nextBudgetCheck(0), improved(nullptr), best(nullptr) {
+    tables();
+}
+
+TwoPhaseSolver::Budget TwoPhaseSolver::Budget::milliseconds(double ms) {
+    Budget b;
+    b.deadline = std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(ms));
+    return b;
+}
+
+TwoPhaseSolver::Budget TwoPhaseSolver::Budget::nodes(uint64_t count) {
+    Budget b;
+    b.maxNodes = count;
+    return b;
+}
+
+bool TwoPhaseSolver::solve(const CubeState& cube, std::vector<int>& solution) {
+    return solve(cube, solution, DEFAULT_MAX_LENGTH);
+}
+
+bool TwoPhaseSolver::solve(const CubeState& cube, std::vector<int>& solution, int maxLength) {
+    solution.clear();
+    if (!cube.isValid()) return false;
+
+    this->maxLength = maxLength < MAX_DEPTH ? maxLength : MAX_DEPTH;
+    anytime = false;
+    budget = Budget();
+    if (!search(cube)) return false;
+    solution.assign(path, path + solutionLength);
+    return true;
+}
+
+bool TwoPhaseSolver::solveAnytime(const CubeState& cube, std::vector<int>& solution, const Budget& budget,
+                                  const std::function<void(const std::vector<int>&)>& improved) {
+    solution.clear();
+    if (!cube.isValid()) return false;
+
+    maxLength = DEFAULT_MAX_LENGTH;
+    anytime = true;
+    this->budget = budget;
+    this->improved = improved ? &improved : nullptr;
+    best = &solution;
+    bool foundAny = search(cube);
+    this->improved = nullptr;
+    best = nullptr;
+    return foundAny;
+}
+
+bool TwoPhaseSolver::search(const CubeState& cube) {
+    const TwoPhaseTables& t = tables();
+    start = cube;
+    found = false;
+    stopped = false;
+    nodes = 0;
+    nextBudgetCheck = 0;
+
+    // In an anytime search maxLength drops below each solution found, which also ends
+    // this loop once no shorter one can exist.
+    int twist = getTwist(cube), flip = getFlip(cube), slice = getSlice(cube);
+    for (int depth = phase1Distance(t, twist, flip, slice); depth <= maxLength; ++depth)
+        if (searchPhase1(twist, flip, slice, 0, depth)) break;
+    return found;
+}
+
+bool TwoPhaseSolver::outOfBudget() {
+    if (nodes < nextBudgetCheck) return false;
+    nextBudgetCheck = nodes + BUDGET_CHECK_INTERVAL;
+    if (nodes >= budget.maxNodes || std::chrono::steady_clock::now() >= budget.deadline
+        || (budget.cancel && budget.cancel->load(std::memory_order_relaxed)))
+        stopped = true;
+    return stopped;
+}
+
+bool TwoPhaseSolver::searchPhase1(int twist, int flip, int slice, int depth, int togo) {
+    const TwoPhaseTables& t = tables();
+    ++nodes;
+    if (outOfBudget()) return true;
+    if (togo == 0) {
+        if (twist != 0 || flip != 0 || slice != 0) return false;
+        // A phase 1 ending in a phase 2 move would have been found one move shorter.
+        if (depth > 0) {
+            int last = path[depth - 1];
+            int face = moveFace(last);
+            if (face == FACE_U || face == FACE_D || movePower(last) == 2) return false;
+        }
+        return startPhase2(depth);
+    }
+    if (phase1Distance(t, twist, flip, slice) > togo) return false;
+
+    int previousFace = depth > 0 ? moveFace(path[depth - 1]) : -1;
+    for (int m = 0; m < N_MOVES; ++m) {
+        if (redundantAfter(moveFace(m), previousFace)) continue;
+        path[depth] = m;
+        if (searchPhase1(twistMoveTable[twist][m], flipMoveTable[flip][m], sliceMoveTable[slice][m], depth + 1, togo - 1))
+            return true;
+    }
+    return false;
+}
+
+bool TwoPhaseSolver::startPhase2(int depth) {
+    const TwoPhaseTables& t = tables();
+    PackedCube packed(start);
+    for (int i = 0; i < depth; ++i) applyMove(packed, path[i]);
+    CubeState cube = packed.toState();
+
+    int cornerPerm = getCornerPerm(cube), edge8Perm = getEdge8Perm(cube), slicePerm = getSlicePerm(cube);
+    for (int togo = phase2Distance(t, cornerPerm, edge8Perm, slicePerm); depth + togo <= maxLength; ++togo) {
+        if (searchPhase2(cornerPerm, edge8Perm, slicePerm, depth, togo)) {
+            if (stopped) return true;
+            solutionLength = depth + togo;
+            found = true;
+            if (!anytime) return true;
+
+            // Keep it and look only for shorter ones from here on.
+            best->assign(path, path + solutionLength);
+            if (improved) (*improved)(*best);
+            maxLength = solutionLength - 1;
+            return false;
+        }
+    }
+    return false;
+}
+
+bool TwoPhaseSolver::searchPhase2(int cornerPerm, int edge8Perm, int slicePerm, int depth, int togo) {
+    const TwoPhaseTables& t = tables();
+    ++nodes;
+    if (outOfBudget()) return true;
+    if (togo == 0) return cornerPerm == 0 && edge8Perm == 0 && slicePerm == 0;
+    if (phase2Distance(t, cornerPerm, edge8Perm, slicePerm) > togo) return false;
+
+    int previousFace = depth > 0 ? moveFace(path[depth - 1]) : -1;
+    for (int k = 0; k < N_PHASE2_MOVES; ++k) {
+        int m = phase2Moves[k];
+        if (redundantAfter(moveFace(m), previousFace)) continue;
+        path[depth] = m;
+        if (searchPhase2(t.cornerPermMove[cornerPerm][k], t.edge8PermMove[edge8Perm][k],
+                         slicePermMove[slicePerm][k], depth + 1, togo - 1))
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,74 @@
+#include "WorkStealingPool.h"
+
+WorkStealingPool::WorkStealingPool(int threads) : nextQueue(0), queued(0), pending(0), stopping(false) {
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+    for (int i = 0; i < threads; ++i) queues.emplace_back(new Queue);
+    for (int i = 0; i < threads; ++i) workers.emplace_back(&WorkStealingPool::run, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+    Queue& queue = *queues[nextQueue++ % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        ++queued;
+        ++pending;
+    }
+    wake.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    idle.wait(lock, [this] { return pending == 0; });
+}
+
+bool WorkStealingPool::take(int self, std::function<void()>& task) {
+    int n = (int)queues.size();
+    for (int k = 0; k < n; ++k) {
+        Queue& queue = *queues[(self + k) % n];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        if (k == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::run(int self) {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wake.wait(lock, [this] { return stopping || queued > 0; });
+            if (queued == 0) return; // Stopping with nothing left to do
+            --queued;
+        }
+        // A task is reserved for us somewhere; it may take a few passes to find it
+        // while other workers are moving theirs.
+        std::function<void()> task;
+        while (!take(self, task)) std::this_thread::yield();
+        task();
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--pending == 0) idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,408 @@
+// cube_bench: micro and macro benchmarks of the cube model and solvers.
+//
+// Prints one JSON object to stdout so results can be stored and compared between
+// versions. Times are wall clock; each micro benchmark reports nanoseconds per
+// operation. The solve corpus is generated from a fixed seed, so runs with the same
+// --seed and --corpus solve the same states: 40-move scrambles by default, or states
+// drawn uniformly from the whole cube group with --uniform.
+
+#include "Coordinates.h"
+#include "CubeState.h"
+#include "OptimalSolver.h"
+#include "PackedCube.h"
+#include "PruningTable.h"
+#include "RandomState.h"
+#include "Symmetry.h"
+#include "ThistlethwaiteSolver.h"
+#include "TwoPhaseSolver.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options
+{
+    unsigned seed = 1;
+    int corpus = 1000;       // Two-phase solves
+    int optimalCorpus = 0;   // Optimal solves, off by default: the tables take a minute to build
+    int optimalLength = 13;  // Scramble length for the optimal corpus, far short of random states' 17-18
+    bool optimalPacked = false; // 4-bit optimal tables instead of mod-3
+    bool optimalLarge = false;  // 7-edge optimal databases instead of 6-edge ones
+    bool quick = false;      // Fewer iterations, for smoke tests
+    bool uniform = false;    // Uniform random states for the two-phase corpus instead of scrambles
+};
+
+using Clock = std::chrono::steady_clock;
+
+double seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Keeps results alive so the compiler cannot drop the work being timed.
+volatile uint64_t sink;
+
+// Minimal writer for the nested JSON report.
+class JsonWriter
+{
+public:
+    JsonWriter() : first(true), depth(0) { std::printf("{"); }
+    ~JsonWriter() { std::printf("\n}\n"); }
+
+    void begin(const char* name) {
+        key(name);
+        std::printf("{");
+        first = true;
+        ++depth;
+    }
+    void end() {
+        --depth;
+        newline();
+        std::printf("}");
+        first = false;
+    }
+    void value(const char* name, double v) {
+        key(name);
+        std::printf("%.6g", v);
+    }
+    void value(const char* name, const char* v) {
+        key(name);
+        std::printf("\"%s\"", v);
+    }
+
+private:
+    bool first;
+    int depth;
+
+    void newline() {
+        std::printf("\n%*s", 2 * (depth + 1), "");
+    }
+    void key(const char* name) {
+        if (!first) std::printf(",");
+        first = false;
+        newline();
+        std::printf("\"%s\": ", name);
+    }
+};
+
+std::vector<int> randomMoves(std::mt19937& rng, int length) {
+    std::vector<int> moves;
+    int previousFace = -1;
+    while ((int)moves.size() < length) {
+        int move = (int)(rng() % N_MOVES);
+        if (moveFace(move) == previousFace) continue;
+        previousFace = moveFace(move);
+        moves.push_back(move);
+    }
+    return moves;
+}
+
+CubeState scrambled(std::mt19937& rng, int length) {
+    CubeState cube;
+    for (int move : randomMoves(rng, length)) cube.apply(move);
+    return cube;
+}
+
+void benchMoves(JsonWriter& json, const Options& options) {
+    const long iterations = options.quick ? 1000000 : 20000000;
+    std::mt19937 rng(options.seed);
+    std::vector<int> moves = randomMoves(rng, 1024);
+
+    json.begin("moves");
+    CubeState cube;
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < iterations; ++i) cube.apply(moves[i & 1023]);
+    json.value("cubestate_apply_ns", seconds(start) * 1e9 / iterations);
+    sink = cube.corners[0];
+
+    const char* initialKernel = packedKernelName();
+    for (const char* kernel : {"scalar", "avx2"}) {
+        if (!usePackedKernel(kernel)) continue;
+        std::string prefix = std::string("packed_") + kernel;
+
+        PackedCube packed;
+        start = Clock::now();
+        for (long i = 0; i < iterations; ++i) applyMove(packed, moves[i & 1023]);
+        json.value((prefix + "_apply_ns").c_str(), seconds(start) * 1e9 / iterations);
+
+        const int batch = 16;
+        PackedCube cubes[batch];
+        start = Clock::now();
+        for (long i = 0; i < iterations / batch; ++i) applyMove(cubes, batch, moves[i & 1023]);
+        json.value((prefix + "_batch16_ns_per_cube").c_str(), seconds(start) * 1e9 / (iterations / batch * batch));
+
+        PackedCube children[N_MOVES];
+        start = Clock::now();
+        for (long i = 0; i < iterations / N_MOVES; ++i) {
+            expandMoves(packed, children);
+            packed = children[moves[i & 1023]];
+        }
+        json.value((prefix + "_expand_ns_per_child").c_str(), seconds(start) * 1e9 / (iterations / N_MOVES * N_MOVES));
+        sink = packed.bytes[0] + cubes[3].bytes[1];
+    }
+    usePackedKernel(initialKernel);
+    json.end();
+}
+
+void benchRandomStates(JsonWriter& json, const Options& options) {
+    const size_t count = options.quick ? (size_t)1 << 20 : (size_t)1 << 24;
+    std::vector<CubeState> states(count);
+    json.begin("random_states");
+    for (int threads : {1, 0}) {
+        Clock::time_point start = Clock::now();
+        randomStates(states.data(), count, options.seed, threads);
+        double elapsed = seconds(start);
+        json.value(threads == 1 ? "1_thread_ns" : "all_threads_ns", elapsed * 1e9 / count);
+        json.value(threads == 1 ? "1_thread_per_s" : "all_threads_per_s", count / elapsed);
+    }
+    int invalid = 0;
+    for (size_t i = 0; i < count; i += 997) invalid += !states[i].isValid();
+    json.value("invalid_sampled", invalid);
+    sink = states[count - 1].corners[0];
+    json.end();
+}
+
+// Times `get` on a fixed set of cubes and `set` over the whole coordinate range.
+void benchCoordinate(JsonWriter& json, const char* name, const std::vector<CubeState>& cubes, int size,
+                     int (*get)(const CubeState&), void (*set)(CubeState&, int), long iterations) {
+    uint64_t total = 0;
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < iterations; ++i) total += get(cubes[i & (cubes.size() - 1)]);
+    json.value((std::string(name) + "_get_ns").c_str(), seconds(start) * 1e9 / iterations);
+
+    CubeState cube;
+    start = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        set(cube, (int)(i % size));
+        total += cube.corners[0] + cube.edges[0];
+    }
+    json.value((std::string(name) + "_set_ns").c_str(), seconds(start) * 1e9 / iterations);
+    sink = total;
+}
+
+void benchCoordinates(JsonWriter& json, const Options& options) {
+    const long iterations = options.quick ? 200000 : 5000000;
+    std::mt19937 rng(options.seed);
+    std::vector<CubeState> cubes(1024);
+    for (CubeState& cube : cubes) cube = scrambled(rng, 30);
+
+    json.begin("coordinates");
+    benchCoordinate(json, "twist", cubes, N_TWIST, getTwist, setTwist, iterations);
+    benchCoordinate(json, "flip", cubes, N_FLIP, getFlip, setFlip, iterations);
+    benchCoordinate(json, "slice", cubes, N_SLICE, getSlice, setSlice, iterations);
+    benchCoordinate(json, "corner_perm", cubes, N_CORNER_PERM, getCornerPerm, setCornerPerm, iterations);
+    benchCoordinate(json, "edge8_perm", cubes, N_EDGE8_PERM, getEdge8Perm, setEdge8Perm, iterations);
+
+    const SymmetryTables& sym = symmetryTables();
+    uint64_t total = 0;
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        const CubeState& cube = cubes[i & 1023];
+        int flipSlice = getFlip(cube) * N_SLICE + getSlice(cube);
+        total += sym.flipSliceClass[flipSlice] + sym.twistConjugate[getTwist(cube)][sym.flipSliceSym[flipSlice]];
+    }
+    json.value("flipslice_sym_twist_get_ns", seconds(start) * 1e9 / iterations);
+    sink = total;
+    json.end();
+}
+
+// Dependent random lookups, so each one waits for the previous: latency, not bandwidth.
+// `entries` must be a power of two.
+double lookupLatency(uint64_t entries, long iterations, unsigned seed) {
+    PruningTable table(entries);
+    std::mt19937_64 rng(seed);
+    for (uint64_t i = 0; i < entries; i += 4093) table.set(i, (int)(rng() % 13));
+    uint64_t index = rng() % entries;
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < iterations; ++i)
+        index = (index * 6364136223846793005ULL + (uint64_t)table.get(index) + 1442695040888963407ULL) & (entries - 1);
+    double ns = seconds(start) * 1e9 / iterations;
+    sink = index;
+    return ns;
+}
+
+void benchLookups(JsonWriter& json, const Options& options) {
+    const long iterations = options.quick ? 200000 : 5000000;
+    json.begin("table_lookup");
+    json.value("entries_64k_ns", lookupLatency(1 << 16, iterations, options.seed));
+    json.value("entries_16m_ns", lookupLatency(1 << 24, iterations, options.seed));
+    if (!options.quick) json.value("entries_256m_ns", lookupLatency((uint64_t)1 << 28, iterations, options.seed));
+    json.end();
+}
+
+void benchGeneration(JsonWriter& json) {
+    // The one move table the optimal solver builds at run time, as it does, per kernel,
+    // and with CubeState moves for comparison
+    static uint16_t cornerPermMove[N_CORNER_PERM][N_MOVES];
+    json.begin("generation");
+    Clock::time_point start = Clock::now();
+    for (int c = 0; c < N_CORNER_PERM; ++c) {
+        CubeState cube;
+        setCornerPerm(cube, c);
+        for (int m = 0; m < N_MOVES; ++m) cornerPermMove[c][m] = (uint16_t)getCornerPerm(cube.applied(m));
+    }
+    json.value("corner_perm_move_table_cubestate_s", seconds(start));
+    const char* initialKernel = packedKernelName();
+    for (const char* kernel : {"scalar", "avx2"}) {
+        if (!usePackedKernel(kernel)) continue;
+        start = Clock::now();
+        buildMoveTable(cornerPermMove, N_CORNER_PERM, allMoves, setCornerPerm, getCornerPerm);
+        json.value((std::string("corner_perm_move_table_") + kernel + "_s").c_str(), seconds(start));
+    }
+    usePackedKernel(initialKernel);
+
+    auto neighbors = [](uint64_t i, uint64_t* out) {
+        int twist = (int)(i / N_SLICE), slice = (int)(i % N_SLICE);
+        for (int m = 0; m < N_MOVES; ++m) out[m] = (uint64_t)twistMoveTable[twist][m] * N_SLICE + sliceMoveTable[slice][m];
+        return N_MOVES;
+    };
+    for (int threads : {1, 0}) {
+        PruningTable table((uint64_t)N_TWIST * N_SLICE);
+        start = Clock::now();
+        table.generate(0, neighbors, threads);
+        json.value(threads == 1 ? "twist_slice_pruning_1_thread_s" : "twist_slice_pruning_all_threads_s", seconds(start));
+    }
+
+    start = Clock::now();
+    ThistlethwaiteSolver();
+    json.value("thistlethwaite_tables_s", seconds(start));
+    json.value("thistlethwaite_table_bytes", (double)ThistlethwaiteSolver::tableBytes());
+
+    start = Clock::now();
+    symmetryTables();
+    json.value("symmetry_tables_s", seconds(start));
+
+    // Loads the two-phase tables from the table directory, or generates them if absent.
+    start = Clock::now();
+    TwoPhaseSolver();
+    json.value("twophase_tables_s", seconds(start));
+    json.end();
+}
+
+template <class Solve>
+void benchSolves(JsonWriter& json, const char* name, const std::vector<CubeState>& corpus, Solve solve) {
+    std::vector<double> times;
+    std::vector<int> solution;
+    uint64_t totalLength = 0;
+    int failures = 0;
+    for (const CubeState& cube : corpus) {
+        Clock::time_point start = Clock::now();
+        bool ok = solve(cube, solution);
+        times.push_back(seconds(start) * 1e3);
+        CubeState check = cube;
+        for (int move : solution) check.apply(move);
+        if (!ok || !check.isSolved()) ++failures;
+        totalLength += solution.size();
+    }
+    std::sort(times.begin(), times.end());
+    auto percentile = [&times](double p) { return times[std::min(times.size() - 1, (size_t)(p * times.size()))]; };
+    double total = 0;
+    for (double t : times) total += t;
+
+    json.begin(name);
+    json.value("count", (double)corpus.size());
+    json.value("failures", failures);
+    json.value("mean_ms", total / times.size());
+    json.value("p50_ms", percentile(0.50));
+    json.value("p95_ms", percentile(0.95));
+    json.value("p99_ms", percentile(0.99));
+    json.value("max_ms", times.back());
+    json.value("mean_length", (double)totalLength / corpus.size());
+    json.end();
+}
+
+void benchSolvers(JsonWriter& json, const Options& options) {
+    json.begin("solve");
+    std::mt19937 rng(options.seed);
+    std::vector<CubeState> corpus(options.corpus);
+    if (options.uniform) randomStates(corpus.data(), corpus.size(), options.seed);
+    else for (CubeState& cube : corpus) cube = scrambled(rng, 40);
+    TwoPhaseSolver twoPhase;
+    benchSolves(json, "twophase", corpus, [&twoPhase](const CubeState& cube, std::vector<int>& solution) {
+        return twoPhase.solve(cube, solution);
+    });
+    ThistlethwaiteSolver thistlethwaite;
+    benchSolves(json, "thistlethwaite", corpus, [&thistlethwaite](const CubeState& cube, std::vector<int>& solution) {
+        return thistlethwaite.solve(cube, solution);
+    });
+
+    if (options.optimalCorpus > 0) {
+        std::vector<CubeState> scrambles(options.optimalCorpus);
+        for (CubeState& cube : scrambles) cube = scrambled(rng, options.optimalLength);
+        OptimalSolver single(1);
+        benchSolves(json, "optimal_1_thread", scrambles, [&single](const CubeState& cube, std::vector<int>& solution) {
+            return single.solve(cube, solution);
+        });
+        OptimalSolver parallel(0);
+        benchSolves(json, "optimal_all_threads", scrambles, [&parallel](const CubeState& cube, std::vector<int>& solution) {
+            return parallel.solve(cube, solution);
+        });
+        json.value("optimal_scramble_length", options.optimalLength);
+        json.value("optimal_threads", parallel.threadCount());
+        json.value("optimal_tables", options.optimalPacked ? "packed4" : "mod3");
+        json.value("optimal_edge_group", options.optimalLarge ? 7 : 6);
+    }
+    json.end();
+}
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --seed N             corpus seed (default 1)\n"
+        "  --corpus N           two-phase solves (default 1000)\n"
+        "  --uniform            uniform random states for the two-phase corpus, not scrambles\n"
+        "  --optimal N          also time N optimal solves of scrambles, single and all threads\n"
+        "  --optimal-length N   scramble length of the optimal corpus (default 13)\n"
+        "  --optimal-packed     4-bit optimal tables instead of 2-bit mod-3 ones\n"
+        "  --optimal-large      7-edge optimal databases instead of 6-edge ones\n"
+        "  --tables DIR         pruning table directory\n"
+        "  --verify-tables      check each table file's hash on load, rebuilding any that fail\n"
+        "  --quick              fewer iterations, for smoke tests\n", program);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(arg, "--seed") && hasValue) options.seed = (unsigned)std::atoi(argv[++i]);
+        else if (!std::strcmp(arg, "--corpus") && hasValue) options.corpus = std::atoi(argv[++i]);
+        else if (!std::strcmp(arg, "--optimal") && hasValue) options.optimalCorpus = std::atoi(argv[++i]);
+        else if (!std::strcmp(arg, "--optimal-length") && hasValue) options.optimalLength = std::atoi(argv[++i]);
+        else if (!std::strcmp(arg, "--optimal-packed")) options.optimalPacked = true;
+        else if (!std::strcmp(arg, "--optimal-large")) options.optimalLarge = true;
+        else if (!std::strcmp(arg, "--tables") && hasValue) PruningTable::setDirectory(argv[++i]);
+        else if (!std::strcmp(arg, "--verify-tables")) PruningTable::setVerify(true);
+        else if (!std::strcmp(arg, "--uniform")) options.uniform = true;
+        else if (!std::strcmp(arg, "--quick")) options.quick = true;
+        else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (options.corpus < 1) options.corpus = 1;
+    OptimalSolver::setCompactTables(!options.optimalPacked);
+    OptimalSolver::setLargeEdgeTables(options.optimalLarge);
+
+    JsonWriter json;
+    json.value("format", 1);
+    json.value("seed", options.seed);
+    json.value("corpus", options.uniform ? "uniform" : "scrambles");
+    json.value("hardware_threads", std::thread::hardware_concurrency());
+    json.value("packed_kernel", packedKernelName());
+    benchMoves(json, options);
+    benchRandomStates(json, options);
+    benchGeneration(json); // Before benchCoordinates and the solvers, which would build the tables it times
+    benchCoordinates(json, options);
+    benchLookups(json, options);
+    benchSolvers(json, options);
+    return 0;
+}
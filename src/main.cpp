@@ -2,12 +2,20 @@
 #include "Shader.h"
 #include "CubePiece.h"
 #include "RubiksCube.h"
+#include "CubeScene.h"
+#include "AsyncSolver.h"
+#include "FrameProfiler.h"
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
 
 
 // Window dimensions
@@ -22,6 +30,10 @@ const float MOUSE_SENSITIVITY = 0.2f;
 static float cameraYaw = 45.0f; // Initial yaw, looking towards -Z
 static float cameraPitch = 45.0f;   // Initial pitch
 static float cameraDistance = 8.0f; // Initial distance from origin
+static float maxCameraDistance = 10.0f;
+static float scrollStep = 0.5f;
+
+static bool showProfilerOverlay = false; // Toggled with P
 
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
     if (button == GLFW_MOUSE_BUTTON_LEFT) {
@@ -52,21 +64,47 @@ void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
-    cameraDistance -= (float)yoffset * 0.5f; // Adjust sensitivity as needed
+    cameraDistance -= (float)yoffset * scrollStep; // Adjust sensitivity as needed
     if (cameraDistance < 1.0f)
         cameraDistance = 1.0f;
-    if (cameraDistance > 10.0f)
-        cameraDistance = 10.0f;
+    if (cameraDistance > maxCameraDistance)
+        cameraDistance = maxCameraDistance;
 }
 
 // Forward declaration for RubiksCube instance if needed by callback
 RubiksCube* globalRubiksCubePtr = nullptr;
+AsyncSolver* globalSolverPtr = nullptr;
+
+// Solves the cube as it will be after the queued moves, in the background; the
+// solution is queued when it arrives, unless a move cancelled the request first.
+void requestSolve(AsyncSolver::Method method) {
+    RubiksCube* cube = globalRubiksCubePtr;
+    std::cout << (method == AsyncSolver::OPTIMAL ? "Searching for an optimal solution..." : "Solving...") << std::endl;
+    globalSolverPtr->request(cube->getTargetState(), method, [cube](const AsyncSolver::Result& result) {
+        if (!result.solved) {
+            if (result.final) std::cout << "No solution found" << std::endl;
+            return;
+        }
+        std::cout << (result.final ? "Solution (" : "Found (") << result.solution.size() << " moves, "
+                  << result.milliseconds << " ms): " << Algorithm(result.solution).toString() << std::endl;
+        if (result.final) cube->queueMoves(result.solution);
+    });
+}
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     bool clockwise = 0;
     if (action == GLFW_PRESS) { // We only care about initial key presses for now
         clockwise = mods & GLFW_MOD_SHIFT; // True if Shift is pressed
+        if (key == GLFW_KEY_P) { // Frame-time overlay, in the cube and the scene alike
+            showProfilerOverlay = !showProfilerOverlay;
+        }
         if (globalRubiksCubePtr) { // Ensure the Rubik's Cube exists
+            bool faceKey = key == GLFW_KEY_R || key == GLFW_KEY_L || key == GLFW_KEY_U
+                        || key == GLFW_KEY_D || key == GLFW_KEY_F || key == GLFW_KEY_B;
+            if (faceKey && globalSolverPtr && globalSolverPtr->busy()) {
+                globalSolverPtr->cancel(); // The solve is for a cube that no longer exists
+                std::cout << "Solve cancelled" << std::endl;
+            }
             if (key == GLFW_KEY_R) {
                 globalRubiksCubePtr->turn("R", clockwise);
             } else if (key == GLFW_KEY_L) {
@@ -79,15 +117,51 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
                 globalRubiksCubePtr->turn("F", clockwise);
             } else if (key == GLFW_KEY_B) {
                 globalRubiksCubePtr->turn("B", clockwise);
+            } else if (key == GLFW_KEY_EQUAL) { // '+': faster playback
+                globalRubiksCubePtr->setPlaybackSpeed(globalRubiksCubePtr->getPlaybackSpeed() * 2.0f);
+            } else if (key == GLFW_KEY_MINUS) {
+                globalRubiksCubePtr->setPlaybackSpeed(globalRubiksCubePtr->getPlaybackSpeed() * 0.5f);
+            } else if (key == GLFW_KEY_I) { // Toggle instant mode
+                globalRubiksCubePtr->setInstantMode(!globalRubiksCubePtr->getInstantMode());
+            } else if (key == GLFW_KEY_S && globalSolverPtr) { // Solve; Shift+S for an optimal solution
+                requestSolve(clockwise ? AsyncSolver::OPTIMAL : AsyncSolver::TWO_PHASE);
+            } else if (key == GLFW_KEY_T && globalSolverPtr) { // Thistlethwaite solve, small tables
+                requestSolve(AsyncSolver::THISTLETHWAITE);
             }
         }
     }
 }
 
+// States for --scene: random 25-move scrambles, the same on every run.
+std::vector<CubeState> sceneStates(int count) {
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> move(0, N_MOVES - 1);
+    std::vector<CubeState> states(count);
+    for (CubeState& state : states)
+        for (int i = 0; i < 25; ++i) state.apply(move(rng));
+    return states;
+}
 
+int main(int argc, char** argv) {
+    // --scene N shows N cubes at once instead of the interactive cube;
+    // --trace FILE writes every frame's timings as CSV, or as a Chrome trace for a .json file
+    int sceneCubes = 0;
+    const char* tracePath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+            sceneCubes = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--scene N] [--trace FILE]\n"
+                      << "  --scene N     N sticker-only cubes on a grid instead of the interactive cube;\n"
+                      << "                10,000 take 20-28 ms a frame on llvmpipe, under 60 FPS\n"
+                      << "  --trace FILE  every frame's timings as CSV, or a Chrome trace for .json"
+                      << std::endl;
+            return 1;
+        }
+    }
 
-
-int main() {
     // 1. Initialize GLFW
     if (!glfwInit()) {
         std::cout << "GLFW Initialization failed!" << std::endl;
@@ -150,25 +224,53 @@ int main() {
     RubiksCube rubiksCube;
     rubiksCube.setupMesh(); // This will call setupMesh for each CubePiece
     globalRubiksCubePtr = &rubiksCube; // Assign address to global pointer
+
+    AsyncSolver solver;
+    globalSolverPtr = &solver;
     
-    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
+    Shader sceneShader("../shaders/scene.vert", "../shaders/scene.frag");
+    Shader spriteShader("../shaders/scene_sprite.vert", "../shaders/scene_sprite.frag");
+    CubeScene scene;
+    float farPlane = 100.0f;
+    if (sceneCubes > 0) {
+        globalRubiksCubePtr = nullptr; // Keys do nothing in the scene
+        scene.setStates(sceneStates(sceneCubes));
+        scene.setupMesh();
+        maxCameraDistance = scene.radius() * 3.0f;
+        cameraDistance = scene.radius() * 1.5f;
+        scrollStep = maxCameraDistance / 40.0f;
+        farPlane = maxCameraDistance + scene.radius();
+    }
+
+    Shader overlayShader("../shaders/overlay.vert", "../shaders/overlay.frag");
+    FrameProfiler profiler;
+    profiler.setup();
+    if (tracePath && !profiler.openTrace(tracePath))
+        std::cout << "Cannot write the trace to " << tracePath << std::endl;
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, farPlane);
+
+    // Looked up once rather than by name every frame
+    const GLint projectionLocation = shader.lookUpLocation("projection");
+    const GLint viewLocation = shader.lookUpLocation("view");
+    const GLint modelLocation = shader.lookUpLocation("model");
 
     // Removed the initial automatic turn, it will now be triggered by key presses.
     float lastFrameTime = 0.0f;
+    float lastTitleTime = 0.0f;
+    int framesSinceTitle = 0;
 
     // 7. Main loop
     while (!glfwWindowShouldClose(window)) {
+        profiler.beginFrame();
+        profiler.begin(FrameProfiler::UPDATE);
+
         // Poll for and process events
         glfwPollEvents();
 
         float currentFrameTime = static_cast<float>(glfwGetTime());
         float deltaTime = currentFrameTime - lastFrameTime;
         lastFrameTime = currentFrameTime;
-        // Clear the color buffer
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f); // Darker background
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Clear depth buffer as well
-
-        shader.use(); // Activate the shader
 
         // Calculate camera position based on yaw, pitch, and distance (orbiting around origin)
         glm::vec3 cameraPos;
@@ -179,22 +281,64 @@ int main() {
         // Update view matrix
         glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 
+        if (sceneCubes == 0) {
+            solver.poll(); // Solutions found since the last frame, if any
+            rubiksCube.update(deltaTime); // Update animation state
+        }
+        profiler.end(FrameProfiler::UPDATE);
 
-        glm::mat4 model = glm::mat4(1.0f); // Start with identity matrix
+        profiler.begin(FrameProfiler::DRAW);
+        // Clear the color buffer
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f); // Darker background
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Clear depth buffer as well
 
-        // Send matrices to the shader
-        shader.setMat4("projection", projection);
-        shader.setMat4("view", view);
-        shader.setMat4("model", model); // This model matrix applies to the whole Rubik's Cube
+        shader.use(); // Activate the shader
 
-        rubiksCube.update(deltaTime); // Update animation state
+        glm::mat4 model = glm::mat4(1.0f); // Start with identity matrix
 
-        rubiksCube.draw(shader);
+        // Send matrices to the shader
+        shader.setMat4(projectionLocation, projection);
+        shader.setMat4(viewLocation, view);
+        shader.setMat4(modelLocation, model); // This model matrix applies to the whole Rubik's Cube
+
+        if (sceneCubes > 0) {
+            scene.draw(sceneShader, spriteShader, projection, view, cameraPos);
+        } else {
+            rubiksCube.draw(shader);
+        }
+        profiler.end(FrameProfiler::DRAW);
+
+        if (showProfilerOverlay) profiler.drawOverlay(overlayShader, WIDTH, HEIGHT);
+
+        // Frame rate, culling results and frame-time percentiles in the title, once a second
+        ++framesSinceTitle;
+        if (currentFrameTime - lastTitleTime >= 1.0f) {
+            std::string title = "Rubiks Cube Solver";
+            if (sceneCubes > 0) {
+                title += " - " + std::to_string(sceneCubes) + " cubes, "
+                    + std::to_string(scene.visibleCount()) + " visible, "
+                    + std::to_string(scene.edgeCount()) + " with edges, "
+                    + std::to_string(scene.spriteCount()) + " as sprites, "
+                    + std::to_string((int)(framesSinceTitle / (currentFrameTime - lastTitleTime))) + " FPS";
+            }
+            if (showProfilerOverlay) title += " - " + profiler.summary();
+            glfwSetWindowTitle(window, title.c_str());
+            lastTitleTime = currentFrameTime;
+            framesSinceTitle = 0;
+        }
 
         // Swap front and back buffers
+        profiler.begin(FrameProfiler::SWAP);
         glfwSwapBuffers(window);
+        profiler.end(FrameProfiler::SWAP);
+        profiler.endFrame();
     }
 
+    profiler.closeTrace();
+    profiler.cleanup();
+    globalSolverPtr = nullptr;
+    scene.cleanupMesh();
+    rubiksCube.cleanupMesh();
     CubePiece::cleanupSharedResources(); // Cleanup shared resources
 
     // 8. Terminate GLFW
@@ -0,0 +1,211 @@
+// cube_render: renders the viewer's cube animation without a display.
+//
+// Plays a move sequence (or the solution of a scramble) on the same RubiksCube
+// renderer as the viewer, in a surfaceless EGL context, with a fixed timestep of one
+// frame per 1/fps seconds, and streams the frames as raw rgb24, Y4M or PNG to a file,
+// a pipe or an image sequence:
+//
+//   cube_render --scramble "R U R' U'" --solve --format y4m -o solve.y4m
+//   cube_render --moves "R U R' U'" --format raw | ffmpeg -f rawvideo -pix_fmt rgb24 -s 512x512 -r 60 -i - out.mp4
+
+#include "OffscreenRenderer.h"
+#include "FrameWriter.h"
+#include "Shader.h"
+#include "CubePiece.h"
+#include "RubiksCube.h"
+#include "Algorithm.h"
+#include "PruningTable.h"
+#include "Solver.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+struct Options
+{
+    int width = 512, height = 512;
+    int fps = 60;
+    float speed = 1.0f;          // Playback speed, as the viewer's +/- keys
+    int holdFrames = 30;         // Still frames before and after the moves
+    int ringSize = 4;            // Pixel buffer objects in flight
+    std::string scramble;        // Applied instantly before the first frame
+    std::string moves;           // Animated
+    bool solve = false;          // Animate a solution of the scramble instead
+    std::string solver = "two-phase"; // Which one finds it, see createSolver
+    float yaw = 45.0f, pitch = 30.0f, distance = 8.0f;
+    FrameWriter::Format format = FrameWriter::Y4M;
+    std::string output = "-";
+    std::string shaders = "../shaders";
+};
+
+void printUsage(const char* program) {
+    std::cerr << "usage: " << program << " [options]\n"
+              << "Renders a cube animation offscreen and writes its frames.\n"
+              << "  --scramble MOVES    starting position (default solved)\n"
+              << "  --moves MOVES       moves to animate\n"
+              << "  --solve             animate a solution of the scramble instead\n"
+              << "  --solver NAME       two-phase (default), optimal or thistlethwaite, for --solve\n"
+              << "  --size WxH          frame size (default 512x512)\n"
+              << "  --fps N             frames per second of animation time (default 60)\n"
+              << "  --speed X           playback speed (default 1: a quarter turn in half a second)\n"
+              << "  --hold N            still frames before and after the moves (default 30)\n"
+              << "  --camera Y,P,D      camera yaw and pitch in degrees and distance (default 45,30,8)\n"
+              << "  --format F          raw (rgb24), y4m or png (default y4m)\n"
+              << "  -o, --output PATH   file, - for stdout (default), or a pattern like f%05d.png\n"
+              << "  --ring N            frames read back asynchronously at once (default 4)\n"
+              << "  --shaders DIR       shader directory (default ../shaders)\n"
+              << "  --tables DIR        pruning table directory, for --solve\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(arg, "--scramble") && hasValue) {
+            options.scramble = argv[++i];
+        } else if (!std::strcmp(arg, "--moves") && hasValue) {
+            options.moves = argv[++i];
+        } else if (!std::strcmp(arg, "--solve")) {
+            options.solve = true;
+        } else if (!std::strcmp(arg, "--solver") && hasValue) {
+            options.solver = argv[++i];
+        } else if (!std::strcmp(arg, "--size") && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2) return false;
+        } else if (!std::strcmp(arg, "--fps") && hasValue) {
+            options.fps = std::atoi(argv[++i]);
+        } else if (!std::strcmp(arg, "--speed") && hasValue) {
+            options.speed = (float)std::atof(argv[++i]);
+        } else if (!std::strcmp(arg, "--hold") && hasValue) {
+            options.holdFrames = std::atoi(argv[++i]);
+        } else if (!std::strcmp(arg, "--camera") && hasValue) {
+            if (std::sscanf(argv[++i], "%f,%f,%f", &options.yaw, &options.pitch, &options.distance) != 3) return false;
+        } else if (!std::strcmp(arg, "--format") && hasValue) {
+            if (!FrameWriter::parseFormat(argv[++i], options.format)) return false;
+        } else if ((!std::strcmp(arg, "-o") || !std::strcmp(arg, "--output")) && hasValue) {
+            options.output = argv[++i];
+        } else if (!std::strcmp(arg, "--ring") && hasValue) {
+            options.ringSize = std::atoi(argv[++i]);
+        } else if (!std::strcmp(arg, "--shaders") && hasValue) {
+            options.shaders = argv[++i];
+        } else if (!std::strcmp(arg, "--tables") && hasValue) {
+            PruningTable::setDirectory(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return options.width > 0 && options.height > 0 && options.fps > 0 && options.speed > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    Algorithm scramble, moves;
+    if (!Algorithm::parse(options.scramble, scramble) || !Algorithm::parse(options.moves, moves)) {
+        std::cerr << "not a valid move sequence\n";
+        return 2;
+    }
+    if (options.solve) {
+        std::unique_ptr<Solver> solver = createSolver(options.solver);
+        if (!solver) {
+            std::cerr << "unknown solver " << options.solver << "\n";
+            return 2;
+        }
+        std::vector<int> solution;
+        if (!solver->solve(scramble.effect(), solution)) {
+            std::cerr << "no solution found\n";
+            return 1;
+        }
+        moves = Algorithm(solution);
+        std::cerr << "solution: " << moves.toString() << "\n";
+    }
+
+    OffscreenRenderer renderer(options.width, options.height, options.ringSize);
+    FrameWriter writer(options.format, options.output, options.width, options.height, options.fps);
+    std::string error;
+    if (!renderer.initialize(error) || !writer.open(error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    // Same state as the viewer's window
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glFrontFace(GL_CCW);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    Shader shader((options.shaders + "/shader.vert").c_str(), (options.shaders + "/shader.frag").c_str());
+    CubePiece::initSharedResources();
+    RubiksCube rubiksCube;
+    rubiksCube.setupMesh();
+
+    // The scramble is in place before the first frame
+    rubiksCube.setInstantMode(true);
+    rubiksCube.queueAlgorithm(scramble);
+    rubiksCube.update(0.0f);
+    rubiksCube.setInstantMode(false);
+    rubiksCube.setMergeMoves(false); // Play the moves exactly as given
+    rubiksCube.setPlaybackSpeed(options.speed);
+
+    glm::vec3 cameraPos;
+    cameraPos.x = options.distance * cos(glm::radians(options.yaw)) * cos(glm::radians(options.pitch));
+    cameraPos.y = options.distance * sin(glm::radians(options.pitch));
+    cameraPos.z = options.distance * sin(glm::radians(options.yaw)) * cos(glm::radians(options.pitch));
+    glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)options.width / (float)options.height, 0.1f, 100.0f);
+    const GLint projectionLocation = shader.lookUpLocation("projection");
+    const GLint viewLocation = shader.lookUpLocation("view");
+    const GLint modelLocation = shader.lookUpLocation("model");
+
+    bool writeFailed = false;
+    auto onFrame = [&](const uint8_t* rgba) {
+        if (!writeFailed && !writer.write(rgba)) writeFailed = true;
+    };
+    auto render = [&](float deltaTime) {
+        rubiksCube.update(deltaTime);
+        renderer.beginFrame();
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        shader.use();
+        shader.setMat4(projectionLocation, projection);
+        shader.setMat4(viewLocation, view);
+        shader.setMat4(modelLocation, glm::mat4(1.0f));
+        rubiksCube.draw(shader);
+        renderer.endFrame(onFrame);
+    };
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const float timestep = 1.0f / options.fps;
+    for (int i = 0; i < options.holdFrames && !writeFailed; ++i) render(0.0f);
+    rubiksCube.queueAlgorithm(moves);
+    render(0.0f); // Starts the first turn
+    while (!rubiksCube.isIdle() && !writeFailed) render(timestep);
+    for (int i = 0; i < options.holdFrames && !writeFailed; ++i) render(0.0f);
+    renderer.finish(onFrame);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << writer.frameCount() << " frames in " << seconds << " s ("
+              << writer.frameCount() / seconds << " fps)\n";
+
+    rubiksCube.cleanupMesh();
+    CubePiece::cleanupSharedResources();
+    if (writeFailed) {
+        std::cerr << "writing frames failed\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,270 @@
+// cube_solve: headless batch solver.
+//
+// Reads one cube per line from a file or stdin, either as a scramble ("R U2 F' ...")
+// or as a 54-character facelet string (see parseFacelets), and writes one line per
+// input to stdout: the solution moves, or "error: ..." for a line that is not a cube.
+// Lines are solved in batches on worker threads, and output keeps the input order.
+// Only a bounded window of batches is in flight, so memory use does not depend on the
+// input size. Solutions are cached up to symmetry and inversion, so a position that
+// comes up again (or any rotation, mirror image or inverse of it) is not solved twice.
+// --solver picks the algorithm (see createSolver): two-phase by default, optimal, or
+// thistlethwaite where memory is short.
+
+#include "Algorithm.h"
+#include "CubeState.h"
+#include "OptimalSolver.h"
+#include "PruningTable.h"
+#include "SolutionCache.h"
+#include "Solver.h"
+#include "TwoPhaseSolver.h"
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int BATCH_SIZE = 64;           // Lines per work item
+const int BATCHES_PER_THREAD = 4;    // In-flight window, per worker
+
+struct Options
+{
+    int threads = 0;
+    std::string solver = "two-phase";
+    int maxLength = TwoPhaseSolver::DEFAULT_MAX_LENGTH;
+    bool maxLengthSet = false;
+    double deadline = 0;  // Per-cube time budget in ms for the anytime search, 0 for none
+    uint64_t maxNodes = 0; // Likewise in search nodes
+    size_t cacheSize = 1 << 16;
+    bool cacheSizeSet = false;
+    bool largeTables = false;
+    const char* input = nullptr;
+};
+
+void printUsage(const char* program) {
+    std::cerr << "usage: " << program << " [options] [file]\n"
+              << "Solves one scramble or facelet string per line of `file` (default stdin).\n"
+              << "  -j, --threads N     worker threads (default: all cores)\n"
+              << "  -n, --max-length N  two-phase solution length limit (default "
+              << TwoPhaseSolver::DEFAULT_MAX_LENGTH << ")\n"
+              << "  --deadline MS       two-phase, per cube: keep shortening the solution for MS ms\n"
+              << "  --nodes N           two-phase, per cube: keep shortening the solution for N nodes\n"
+              << "  --solver NAME       two-phase (default), optimal (shortest; seconds up to 14-15\n"
+              << "                      moves, hours for typical 17-18 move states)\n"
+              << "                      or thistlethwaite (longer solutions, under 2 MB of tables)\n"
+              << "  --optimal           same as --solver optimal\n"
+              << "  --large-tables      optimal: 7-edge databases, 256 MB instead of 21 MB and\n"
+              << "                      about 8 minutes to generate, for 3-4x faster deep solves\n"
+              << "  --cache N           solutions remembered for repeated positions (default "
+              << Options().cacheSize << ",\n"
+              << "                      0 for thistlethwaite; 0 disables)\n"
+              << "  --tables DIR        pruning table directory (default $CUBE_TABLE_DIR or tables)\n"
+              << "  --verify-tables     check each table file's hash on load, rebuilding any that fail\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if ((!std::strcmp(arg, "-j") || !std::strcmp(arg, "--threads")) && hasValue) {
+            options.threads = std::atoi(argv[++i]);
+        } else if ((!std::strcmp(arg, "-n") || !std::strcmp(arg, "--max-length")) && hasValue) {
+            options.maxLength = std::atoi(argv[++i]);
+            options.maxLengthSet = true;
+        } else if (!std::strcmp(arg, "--deadline") && hasValue) {
+            options.deadline = std::atof(argv[++i]);
+        } else if (!std::strcmp(arg, "--nodes") && hasValue) {
+            options.maxNodes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(arg, "--cache") && hasValue) {
+            options.cacheSize = std::strtoull(argv[++i], nullptr, 10);
+            options.cacheSizeSet = true;
+        } else if (!std::strcmp(arg, "--solver") && hasValue) {
+            options.solver = argv[++i];
+        } else if (!std::strcmp(arg, "--optimal")) {
+            options.solver = "optimal";
+        } else if (!std::strcmp(arg, "--large-tables")) {
+            options.largeTables = true;
+        } else if (!std::strcmp(arg, "--tables") && hasValue) {
+            PruningTable::setDirectory(argv[++i]);
+        } else if (!std::strcmp(arg, "--verify-tables")) {
+            PruningTable::setVerify(true);
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            return false;
+        } else if (!options.input) {
+            options.input = arg;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A facelet string if the line is one 54-character word, a move sequence otherwise.
+bool parseCube(const std::string& line, CubeState& cube) {
+    std::istringstream words(line);
+    std::string word;
+    std::vector<std::string> tokens;
+    while (words >> word) tokens.push_back(word);
+    if (tokens.size() == 1 && tokens[0].size() == 54) return parseFacelets(tokens[0], cube);
+
+    Algorithm scramble;
+    if (!Algorithm::parse(line, scramble)) return false;
+    cube = scramble.effect();
+    return true;
+}
+
+class BatchSolver
+{
+public:
+    BatchSolver(std::istream& input, const Options& options, int threads)
+        : input(input), options(options), window(threads * BATCHES_PER_THREAD), cache(options.cacheSize),
+          nextBatch(0), written(0), inputDone(false) {}
+
+    void run(int threads) {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) workers.emplace_back(&BatchSolver::work, this);
+        for (std::thread& worker : workers) worker.join();
+        std::cout.flush();
+    }
+
+private:
+    std::istream& input;
+    const Options& options;
+    const uint64_t window;
+    SolutionCache cache; // Shared by the workers
+
+    // Input reading, ordering and output are all under one lock; each is cheap next to
+    // solving a batch.
+    std::mutex mutex;
+    std::condition_variable room;
+    uint64_t nextBatch;
+    uint64_t written;
+    bool inputDone;
+    std::map<uint64_t, std::string> finished; // Batches done but waiting for earlier ones
+
+    // Best solution within the per-cube budget and the length limit.
+    bool solveAnytime(TwoPhaseSolver& solver, const CubeState& cube, std::vector<int>& solution) const {
+        TwoPhaseSolver::Budget budget;
+        if (options.deadline > 0) budget = TwoPhaseSolver::Budget::milliseconds(options.deadline);
+        if (options.maxNodes > 0) budget.maxNodes = options.maxNodes;
+        return solver.solveAnytime(cube, solution, budget) && (int)solution.size() <= options.maxLength;
+    }
+
+    void work() {
+        std::unique_ptr<Solver> solver = createSolver(options.solver);
+        TwoPhaseSolver* twoPhase = dynamic_cast<TwoPhaseSolver*>(solver.get()); // For the length limit and budgets
+
+        std::vector<std::string> lines(BATCH_SIZE);
+        std::vector<int> solution;
+        for (;;) {
+            uint64_t batch;
+            int count = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                room.wait(lock, [this] { return inputDone || nextBatch - written < window; });
+                while (!inputDone && count < BATCH_SIZE) {
+                    if (std::getline(input, lines[count])) ++count;
+                    else inputDone = true;
+                }
+                if (count == 0) return;
+                batch = nextBatch++;
+            }
+
+            std::string output;
+            for (int i = 0; i < count; ++i) {
+                CubeState cube;
+                if (!parseCube(lines[i], cube)) {
+                    output += "error: not a valid scramble or cube\n";
+                    continue;
+                }
+                bool solved = cache.lookup(cube, solution);
+                if (!solved) {
+                    if (!twoPhase) solved = solver->solve(cube, solution);
+                    else if (options.deadline > 0 || options.maxNodes > 0) solved = solveAnytime(*twoPhase, cube, solution);
+                    else solved = twoPhase->solve(cube, solution, options.maxLength);
+                    if (solved) cache.store(cube, solution);
+                }
+                if (!solved) {
+                    output += "error: no solution found\n";
+                    continue;
+                }
+                for (size_t k = 0; k < solution.size(); ++k) {
+                    if (k) output += ' ';
+                    output += moveName(solution[k]);
+                }
+                output += '\n';
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            finished[batch] = std::move(output);
+            bool advanced = false;
+            for (auto next = finished.begin(); next != finished.end() && next->first == written;
+                 next = finished.erase(next)) {
+                std::cout << next->second;
+                ++written;
+                advanced = true;
+            }
+            if (advanced) {
+                std::cout.flush();
+                room.notify_all();
+            }
+        }
+    }
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    std::ios::sync_with_stdio(false);
+
+    std::ifstream file;
+    if (options.input && std::strcmp(options.input, "-") != 0) {
+        file.open(options.input);
+        if (!file) {
+            std::cerr << "cannot open " << options.input << "\n";
+            return 1;
+        }
+    }
+    std::istream& input = file.is_open() ? file : std::cin;
+
+    int threads = options.threads > 0 ? options.threads : (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+
+    // The length limit and the budgets are the two-phase search's, and the large tables the
+    // optimal one's; no other solver could honour them.
+    if (options.solver != "two-phase" && (options.maxLengthSet || options.deadline > 0 || options.maxNodes > 0)) {
+        std::cerr << "-n, --deadline and --nodes need --solver two-phase\n";
+        return 2;
+    }
+    if (options.largeTables && options.solver != "optimal") {
+        std::cerr << "--large-tables needs --solver optimal\n";
+        return 2;
+    }
+    OptimalSolver::setLargeEdgeTables(options.largeTables);
+
+    // Thistlethwaite solves cost less than cache lookups, and the cache's symmetry tables
+    // are many times the size of its own, so it goes without unless asked for.
+    if (options.solver == "thistlethwaite" && !options.cacheSizeSet) options.cacheSize = 0;
+
+    // Set up the shared tables once before the workers start.
+    if (!createSolver(options.solver)) {
+        std::cerr << "unknown solver " << options.solver << "\n";
+        return 2;
+    }
+
+    BatchSolver(input, options, threads).run(threads);
+    return 0;
+}
@@ -0,0 +1,396 @@
+// cube_tests: checks of the cube model, its fast paths and the solvers.
+//
+// Each test belongs to a group; with no arguments every test runs, otherwise only the
+// groups and tests named on the command line. The "core" group takes well under a
+// second. The "solvers" group sets up the pruning tables like any other solver run:
+// mapped from the table directory ($CUBE_TABLE_DIR, else "tables") when present,
+// otherwise generated and saved there, which takes a minute or two once.
+// Random inputs come from fixed seeds, so every run checks the same states.
+
+#include "Algorithm.h"
+#include "Coordinates.h"
+#include "CubeState.h"
+#include "OptimalSolver.h"
+#include "PackedCube.h"
+#include "PruningTable.h"
+#include "RandomState.h"
+#include "SolutionCache.h"
+#include "Symmetry.h"
+#include "ThistlethwaiteSolver.h"
+#include "TwoPhaseSolver.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* expression, const char* file, int line) {
+    if (condition) return;
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    ++failures;
+}
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+std::vector<CubeState> randomCubes(int count, uint64_t seed) {
+    RandomStream rng(seed);
+    std::vector<CubeState> cubes;
+    for (int i = 0; i < count; ++i) cubes.push_back(randomState(rng));
+    return cubes;
+}
+
+// Whether applying `solution` to `cube` gives the solved cube.
+bool solves(const CubeState& cube, const std::vector<int>& solution) {
+    CubeState state = cube;
+    for (int move : solution) state.apply(move);
+    return state.isSolved();
+}
+
+void testFacelets() {
+    CHECK(toFacelets(CubeState()) == "UUUUUUUUURRRRRRRRRFFFFFFFFFDDDDDDDDDLLLLLLLLLBBBBBBBBB");
+    for (const CubeState& cube : randomCubes(1000, 1)) {
+        CubeState parsed;
+        CHECK(parseFacelets(toFacelets(cube), parsed) && parsed == cube);
+    }
+
+    // Colours are taken from the centers, whatever characters stand for them.
+    CubeState cube = CubeState().applied(makeMove(FACE_R, 1));
+    std::string colours = toFacelets(cube);
+    for (char& c : colours) c = "wrgybo"[std::string("URFDLB").find(c)];
+    CubeState parsed;
+    CHECK(parseFacelets(colours, parsed) && parsed == cube);
+
+    // Twisting one corner in place leaves an unsolvable cube.
+    std::string twisted = toFacelets(CubeState());
+    std::swap(twisted[8], twisted[9]);
+    std::swap(twisted[9], twisted[20]);
+    CHECK(!parseFacelets(twisted, parsed));
+    CHECK(!parseFacelets("UUU", parsed));
+}
+
+void testInverseMultiply() {
+    std::vector<CubeState> cubes = randomCubes(300, 2);
+    for (size_t i = 0; i + 2 < cubes.size(); ++i) {
+        const CubeState &a = cubes[i], &b = cubes[i + 1], &c = cubes[i + 2];
+        CHECK(a.isValid());
+        CubeState product = a;
+        product.multiply(a.inverse());
+        CHECK(product.isSolved());
+        product = a.inverse();
+        product.multiply(a);
+        CHECK(product.isSolved());
+        CHECK(a.inverse().inverse() == a);
+
+        CubeState left = a, right = b;
+        left.multiply(b);
+        left.multiply(c);
+        right.multiply(c);
+        CubeState whole = a;
+        whole.multiply(right);
+        CHECK(left == whole);
+
+        // (ab)^-1 = b^-1 a^-1
+        CubeState ab = a;
+        ab.multiply(b);
+        CubeState reversed = b.inverse();
+        reversed.multiply(a.inverse());
+        CHECK(ab.inverse() == reversed);
+    }
+    for (int m = 0; m < N_MOVES; ++m) {
+        CubeState moved = cubes[0];
+        moved.multiply(CubeState().applied(m));
+        CHECK(moved == cubes[0].applied(m));
+        CHECK(CubeState().applied(m).inverse() == CubeState().applied(inverseMove(m)));
+        CHECK(parseMove(moveName(m)) == m);
+    }
+}
+
+// The AVX2 kernel (when the CPU has it) against the scalar one, and both against
+// CubeState.
+void testPackedKernels() {
+    std::vector<CubeState> cubes = randomCubes(64, 3);
+    std::vector<const char*> kernels = {"scalar"};
+    const char* initial = packedKernelName();
+    if (usePackedKernel("avx2")) kernels.push_back("avx2");
+
+    std::vector<std::vector<PackedCube>> results;
+    for (const char* name : kernels) {
+        CHECK(usePackedKernel(name));
+        std::vector<PackedCube> out;
+        for (const CubeState& cube : cubes) {
+            PackedCube packed(cube);
+            CHECK(packed.toState() == cube);
+            PackedCube children[N_MOVES];
+            expandMoves(packed, children);
+            for (int m = 0; m < N_MOVES; ++m) {
+                PackedCube single = packed;
+                applyMove(single, m);
+                CHECK(single.toState() == cube.applied(m));
+                CHECK(children[m] == single);
+                out.push_back(single);
+            }
+        }
+        for (int m = 0; m < N_MOVES; ++m) {
+            std::vector<PackedCube> batch(cubes.begin(), cubes.end());
+            applyMove(batch.data(), (int)batch.size(), m);
+            for (size_t i = 0; i < cubes.size(); ++i) CHECK(batch[i].toState() == cubes[i].applied(m));
+        }
+        std::vector<PackedCube> batch(cubes.begin(), cubes.end());
+        applyPermutation(batch.data(), (int)batch.size(), cubes[7]);
+        for (size_t i = 0; i < cubes.size(); ++i) {
+            CubeState expected = cubes[i];
+            expected.multiply(cubes[7]);
+            CHECK(batch[i].toState() == expected);
+            out.push_back(batch[i]);
+        }
+        // Run-time move tables expand through the kernel
+        static uint16_t cornerPermMove[N_CORNER_PERM][N_MOVES];
+        buildMoveTable(cornerPermMove, N_CORNER_PERM, allMoves, setCornerPerm, getCornerPerm);
+        for (int p = 0; p < N_CORNER_PERM; p += 97) {
+            CubeState cube;
+            setCornerPerm(cube, p);
+            for (int m = 0; m < N_MOVES; ++m) CHECK(cornerPermMove[p][m] == getCornerPerm(cube.applied(m)));
+        }
+        results.push_back(out);
+    }
+    for (size_t k = 1; k < results.size(); ++k) CHECK(results[k] == results[0]);
+    usePackedKernel(initial);
+}
+
+void testAlgorithm() {
+    Algorithm a;
+    CHECK(Algorithm::parse("R R", a) && a.toString() == "R2");
+    CHECK(Algorithm::parse("R U U' R'", a) && a.length() == 0 && a.effect().isSolved());
+    CHECK(Algorithm::parse("U D U'", a) && a.toString() == "D");
+    CHECK(Algorithm::parse("R2'", a) && a.toString() == "R2");
+    CHECK(Algorithm::parse("RUR'U'", a) && a.toString() == "R U R' U'");
+
+    Algorithm unchanged;
+    CHECK(Algorithm::parse("F", unchanged));
+    CHECK(!Algorithm::parse("R X", unchanged) && unchanged.toString() == "F");
+    CHECK(!Algorithm::parse("R3", unchanged) && unchanged.toString() == "F");
+
+    RandomStream rng(4);
+    for (int i = 0; i < 200; ++i) {
+        std::vector<int> moves;
+        CubeState state;
+        for (int k = 0; k < 30; ++k) {
+            moves.push_back((int)rng.below(N_MOVES));
+            state.apply(moves.back());
+        }
+        Algorithm algorithm(moves);
+        CHECK(algorithm.effect() == state);
+        CHECK(algorithm.length() <= 30);
+        // Simplified: no two neighbours on the same face, no three on the same axis
+        const std::vector<int>& simplified = algorithm.moves();
+        for (size_t k = 1; k < simplified.size(); ++k) {
+            CHECK(moveFace(simplified[k]) != moveFace(simplified[k - 1]));
+            if (k >= 2) {
+                int axis = moveFace(simplified[k]) % 3;
+                CHECK(moveFace(simplified[k - 1]) % 3 != axis || moveFace(simplified[k - 2]) % 3 != axis);
+            }
+        }
+        Algorithm reparsed;
+        CHECK(Algorithm::parse(algorithm.toString(), reparsed) && reparsed.moves() == simplified);
+        CubeState undone = state;
+        algorithm.inverse().applyTo(undone);
+        CHECK(undone.isSolved());
+    }
+}
+
+// Chi-square statistics of a few cubie features over many uniform states, against
+// thresholds no fair sample of this size gets near (p < 1e-4).
+void testRandomStates() {
+    const int SAMPLES = 96000;
+    std::vector<CubeState> cubes(SAMPLES);
+    randomStates(cubes.data(), SAMPLES, 5, 1);
+    std::vector<CubeState> threaded(SAMPLES);
+    randomStates(threaded.data(), SAMPLES, 5, 3);
+    CHECK(threaded == cubes);
+
+    int cornerAt0[8] = {}, twistAt0[3] = {}, edgeAt0[12] = {}, flipAt0[2] = {}, parity[2] = {};
+    for (const CubeState& cube : cubes) {
+        CHECK(cube.isValid());
+        ++cornerAt0[cube.cornerPiece(0)];
+        ++twistAt0[cube.cornerOrientation(0)];
+        ++edgeAt0[cube.edgePiece(0)];
+        ++flipAt0[cube.edgeOrientation(0)];
+        ++parity[cube.cornerParity()];
+    }
+    auto chiSquare = [](const int* counts, int n) {
+        double expected = (double)SAMPLES / n, sum = 0;
+        for (int i = 0; i < n; ++i) sum += (counts[i] - expected) * (counts[i] - expected) / expected;
+        return sum;
+    };
+    CHECK(chiSquare(cornerAt0, 8) < 29.9);
+    CHECK(chiSquare(twistAt0, 3) < 18.4);
+    CHECK(chiSquare(edgeAt0, 12) < 37.7);
+    CHECK(chiSquare(flipAt0, 2) < 15.2);
+    CHECK(chiSquare(parity, 2) < 15.2);
+}
+
+// Every one of the 96 symmetry conjugates and inverses of a position maps to the same
+// cache key, and a stored solution comes back solving each of them.
+void testSolutionCache() {
+    for (const CubeState& cube : randomCubes(20, 6)) {
+        SolutionCache::Canonical key = SolutionCache::canonical(cube);
+        for (int inverted = 0; inverted < 2; ++inverted) {
+            CubeState base = inverted ? cube.inverse() : cube;
+            for (int sym = 0; sym < N_SYM; ++sym) {
+                CubeState variant = conjugate(base, sym);
+                SolutionCache::Canonical other = SolutionCache::canonical(variant);
+                CHECK(other.state == key.state);
+                CHECK(other.hash == key.hash);
+                // The reported symmetry and inversion relate the variant to the key.
+                CubeState source = other.inverted ? variant.inverse() : variant;
+                CHECK(conjugate(source, other.sym) == other.state);
+            }
+        }
+    }
+
+    // Store a known solution of one position, then look up its conjugates and inverses.
+    RandomStream rng(7);
+    std::vector<int> scramble;
+    for (int k = 0; k < 25; ++k) scramble.push_back((int)rng.below(N_MOVES));
+    Algorithm algorithm(scramble);
+    CubeState cube = algorithm.effect();
+    SolutionCache cache(64);
+    cache.store(cube, algorithm.inverse().moves());
+    for (int inverted = 0; inverted < 2; ++inverted) {
+        CubeState base = inverted ? cube.inverse() : cube;
+        for (int sym = 0; sym < N_SYM; ++sym) {
+            CubeState variant = conjugate(base, sym);
+            std::vector<int> solution;
+            CHECK(cache.lookup(variant, solution));
+            CHECK(solves(variant, solution));
+            CHECK((int)solution.size() == algorithm.length());
+        }
+    }
+    CHECK(cache.size() == 1);
+}
+
+// PACKED4 against its MOD3 copy on the corner twist coordinate: exact distances from
+// the parent's, and root distances walked down from residues alone.
+void testPruningEncodings() {
+    auto neighbors = [](uint64_t i, uint64_t* out) {
+        for (int m = 0; m < N_MOVES; ++m) out[m] = twistMoveTable[(int)i][m];
+        return N_MOVES;
+    };
+    PruningTable packed(N_TWIST);
+    packed.generate(0, neighbors, 2);
+    PruningTable mod3 = packed.toMod3();
+    CHECK(mod3.tableEncoding() == PruningTable::MOD3);
+    CHECK(mod3.payloadSize() == (N_TWIST + 3) / 4);
+
+    int deepest = 0;
+    uint64_t out[N_MOVES];
+    for (uint64_t i = 0; i < N_TWIST; ++i) {
+        int distance = packed.get(i);
+        deepest = std::max(deepest, distance);
+        CHECK(distance != PruningTable::EMPTY);
+        CHECK(mod3.get(i) == distance % 3);
+        CHECK(mod3.rootDistance(i, 0, neighbors) == distance);
+        CHECK(packed.rootDistance(i, 0, neighbors) == distance);
+        int n = neighbors(i, out);
+        for (int k = 0; k < n; ++k) CHECK(mod3.distance(out[k], distance) == packed.get(out[k]));
+    }
+    CHECK(deepest == 6); // Corner orientations need at most six moves
+
+    // A residue with no neighbour below it is reported, not walked past.
+    PruningTable broken = PruningTable(N_TWIST);
+    for (uint64_t i = 0; i < N_TWIST; ++i) broken.set(i, packed.get(i) == 0 ? 0 : 4);
+    PruningTable brokenMod3 = broken.toMod3();
+    uint64_t far = 1;
+    while (packed.get(far) < 2) ++far;
+    CHECK(brokenMod3.rootDistance(far, 0, neighbors) == -1);
+}
+
+template <class SolverType>
+void checkSolver(SolverType& solver, const std::vector<CubeState>& cubes, int maxLength) {
+    for (const CubeState& cube : cubes) {
+        std::vector<int> solution;
+        CHECK(solver.solve(cube, solution));
+        CHECK(solves(cube, solution));
+        CHECK((int)solution.size() <= maxLength);
+    }
+    std::vector<int> solution = {0};
+    CHECK(solver.solve(CubeState(), solution) && solution.empty());
+    CubeState invalid;
+    std::swap(invalid.edges[0], invalid.edges[1]);
+    CHECK(!solver.solve(invalid, solution));
+}
+
+void testTwoPhase() {
+    TwoPhaseSolver solver;
+    checkSolver(solver, randomCubes(50, 8), 22);
+}
+
+void testThistlethwaite() {
+    ThistlethwaiteSolver solver;
+    checkSolver(solver, randomCubes(2000, 9), ThistlethwaiteSolver::MAX_LENGTH);
+}
+
+// Short scrambles keep the search quick; the solution may not be longer than the
+// scramble, and a position known to need four moves shows it is shortest.
+void testOptimal() {
+    OptimalSolver solver;
+    std::vector<CubeState> cubes;
+    RandomStream rng(10);
+    for (int i = 0; i < 20; ++i) {
+        CubeState cube;
+        for (int k = 0; k < 9; ++k) cube.apply((int)rng.below(N_MOVES));
+        cubes.push_back(cube);
+    }
+    checkSolver(solver, cubes, 9);
+
+    // R U R' U' has no shorter solution.
+    CubeState sexy;
+    for (const char* name : {"R", "U", "R'", "U'"}) sexy.apply(parseMove(name));
+    std::vector<int> solution;
+    CHECK(solver.solve(sexy, solution) && solution.size() == 4);
+}
+
+struct Test
+{
+    const char* group;
+    const char* name;
+    void (*run)();
+};
+
+const Test TESTS[] = {
+    {"core", "facelets", testFacelets},
+    {"core", "inverse-multiply", testInverseMultiply},
+    {"core", "packed-kernels", testPackedKernels},
+    {"core", "algorithm", testAlgorithm},
+    {"core", "random-states", testRandomStates},
+    {"core", "solution-cache", testSolutionCache},
+    {"core", "pruning-encodings", testPruningEncodings},
+    {"solvers", "thistlethwaite", testThistlethwaite},
+    {"solvers", "two-phase", testTwoPhase},
+    {"solvers", "optimal", testOptimal},
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int run = 0;
+    for (const Test& test : TESTS) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; ++i)
+            selected = selected || !std::strcmp(argv[i], test.group) || !std::strcmp(argv[i], test.name);
+        if (!selected) continue;
+        int before = failures;
+        test.run();
+        std::printf("%-20s %s\n", test.name, failures == before ? "ok" : "FAILED");
+        ++run;
+    }
+    if (run == 0) {
+        std::fprintf(stderr, "usage: %s [group or test ...]\n", argv[0]);
+        return 2;
+    }
+    return failures == 0 ? 0 : 1;
+}